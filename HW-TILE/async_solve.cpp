@@ -0,0 +1,101 @@
+#include "async_solve.h"
+#include "tiling.h"
+
+using namespace std;
+
+TilingFuture::TilingFuture(shared_ptr<Shared> shared)
+	: shared(move(shared))
+{
+}
+
+SolveState TilingFuture::state() const
+{
+	return shared->state.load();
+}
+
+bool TilingFuture::ready() const
+{
+	SolveState s = state();
+	return s != SolveState::Queued && s != SolveState::Running;
+}
+
+bool TilingFuture::get() const
+{
+	while (!ready())
+	{
+		if (shared->pool->run_one())
+			continue;
+
+		unique_lock<mutex> guard(shared->lock);
+		shared->finished.wait_for(guard, chrono::milliseconds(1), [this] { return ready(); });
+	}
+
+	// Don't return while finish() may still hold the lock.
+	lock_guard<mutex> guard(shared->lock);
+	return shared->state.load() == SolveState::Tiled;
+}
+
+void TilingFuture::cancel() const
+{
+	shared->cancelRequested.store(true);
+	SolveState queued = SolveState::Queued;
+	if (shared->state.compare_exchange_strong(queued, SolveState::Cancelled))
+		finish(*shared, SolveState::Cancelled);
+}
+
+void TilingFuture::then(function<void()> continuation) const
+{
+	if (!add_continuation(continuation))
+		continuation();
+}
+
+bool TilingFuture::add_continuation(function<void()> continuation) const
+{
+	lock_guard<mutex> guard(shared->lock);
+	if (ready())
+		return false;
+	shared->continuations.push_back(move(continuation));
+	return true;
+}
+
+void TilingFuture::run(const shared_ptr<Shared> &shared)
+{
+	// A solve cancelled while queued has already finished.
+	SolveState queued = SolveState::Queued;
+	if (!shared->state.compare_exchange_strong(queued, SolveState::Running))
+		return;
+
+	// A cancel() arriving after the solve has decided the floor doesn't
+	// throw its answer away.
+	TilingContext &context = local_context();
+	bool answer = context.solve(shared->floor, &shared->cancelRequested);
+	if (context.cancelled())
+		finish(*shared, SolveState::Cancelled);
+	else
+		finish(*shared, answer ? SolveState::Tiled : SolveState::NoTiling);
+}
+
+void TilingFuture::finish(Shared &shared, SolveState state)
+{
+	vector<function<void()>> continuations;
+	{
+		lock_guard<mutex> guard(shared.lock);
+		shared.state.store(state);
+		continuations.swap(shared.continuations);
+		shared.floor = string();
+	}
+	shared.finished.notify_all();
+	for (function<void()> &continuation : continuations)
+		continuation();
+}
+
+TilingFuture has_tiling_async(string floor, ThreadPool &pool)
+{
+	auto shared = make_shared<TilingFuture::Shared>();
+	shared->floor = move(floor);
+	shared->pool = &pool;
+	shared->state.store(SolveState::Queued);
+	shared->cancelRequested.store(false);
+	pool.submit([shared] { TilingFuture::run(shared); });
+	return TilingFuture(shared);
+}
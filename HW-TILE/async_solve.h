@@ -0,0 +1,103 @@
+#ifndef ASYNC_SOLVE_H
+#define ASYNC_SOLVE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "thread_pool.h"
+
+using namespace std;
+
+// Outcome of an asynchronous solve.
+enum class SolveState
+{
+	Queued,
+	Running,
+	NoTiling,
+	Tiled,
+	Cancelled,
+};
+
+// Handle to a floor being solved on a pool, returned by has_tiling_async.
+//
+// Nothing waits on a thread while the floor is solved: callers either
+// register a continuation with then(), or co_await the handle from a
+// C++20 coroutine, which resumes on the worker that finished the solve.
+// get() blocks for callers that want to. Handles are cheap to copy, and
+// all copies refer to the same solve.
+class TilingFuture
+{
+public:
+	// Returns the current state. Once it is NoTiling, Tiled or Cancelled
+	// it no longer changes.
+	SolveState state() const;
+	bool ready() const;
+
+	// Waits for the solve to finish, running queued tasks of the pool in
+	// the meantime, and returns whether the floor has a tiling. A
+	// cancelled solve returns false.
+	bool get() const;
+
+	// Asks the solve to stop. A solve that has not started yet finishes
+	// at once as Cancelled; a running one notices between its stages,
+	// between rooms and between the augmenting paths of its flow, and so
+	// frees its worker soon after. A solve that finished first keeps its
+	// answer.
+	void cancel() const;
+
+	// Calls continuation once the solve finishes, on the thread that
+	// finished it, or right away if it already has.
+	void then(function<void()> continuation) const;
+
+	// The awaitable interface: co_await yields the same answer as get().
+	bool await_ready() const
+	{
+		return ready();
+	}
+
+	template <typename Handle>
+	bool await_suspend(Handle handle) const
+	{
+		return add_continuation([handle]() mutable { handle.resume(); });
+	}
+
+	bool await_resume() const
+	{
+		return get();
+	}
+
+private:
+	struct Shared
+	{
+		string floor;
+		ThreadPool *pool;
+		atomic<SolveState> state;
+		atomic<bool> cancelRequested;
+		mutex lock;
+		condition_variable finished;
+		vector<function<void()>> continuations;
+	};
+
+	shared_ptr<Shared> shared;
+
+	explicit TilingFuture(shared_ptr<Shared> shared);
+
+	// Registers continuation unless the solve has already finished.
+	// Returns whether it was registered.
+	bool add_continuation(function<void()> continuation) const;
+
+	static void run(const shared_ptr<Shared> &shared);
+	static void finish(Shared &shared, SolveState state);
+
+	friend TilingFuture has_tiling_async(string floor, ThreadPool &pool);
+};
+
+// Starts solving the floor on the pool and returns at once. The floor is
+// moved into the handle, so the caller need not keep it alive.
+TilingFuture has_tiling_async(string floor, ThreadPool &pool = default_pool());
+
+#endif
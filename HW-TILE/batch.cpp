@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "batch.h"
+#include "floor.h"
+#include "tiling.h"
+#include "tiny_lanes.h"
+
+using namespace std;
+
+// Floors are grouped into one task until the group holds this many bytes.
+static const size_t ChunkBytes = 64 * 1024;
+// Floors of at least this many bytes are split into components.
+static const size_t SplitBytes = 256 * 1024;
+// A floor is scheduled on its own when it costs at least this share
+// of the whole batch divided by the number of workers.
+static const double LargeShare = 0.25;
+
+// Shared state of one call to has_tiling_batch.
+struct BatchState
+{
+	const string_view* floors;
+	unique_ptr<atomic<bool>[]> results;
+	const function<void(size_t, bool)>* onResult;
+	mutex reportLock;
+	TaskGroup group;
+
+	// Records the final answer for floor i.
+	void finish(size_t i, bool answer)
+	{
+		results[i].store(answer, memory_order_relaxed);
+		if (*onResult)
+		{
+			lock_guard<mutex> guard(reportLock);
+			(*onResult)(i, answer);
+		}
+	}
+};
+
+// Solves the components of floor i as separate tasks on the
+// current worker's queue, where idle workers can steal them.
+static void solve_split(size_t i, BatchState &state, ThreadPool &pool)
+{
+	struct Split
+	{
+		vector<string> parts;
+		atomic<size_t> remaining;
+		atomic<bool> ok;
+	};
+	auto split = make_shared<Split>();
+	split->parts = split_components(state.floors[i]);
+	split->remaining.store(split->parts.size());
+	split->ok.store(true);
+
+	if (split->parts.empty())
+	{
+		state.finish(i, true);
+		return;
+	}
+
+	state.group.add(split->parts.size());
+	for (size_t k = 0; k < split->parts.size(); ++k)
+	{
+		pool.submit([split, k, i, &state]
+		{
+			// Once one component fails the answer is known.
+			if (split->ok.load(memory_order_relaxed) && !local_context().solve(split->parts[k]))
+				split->ok.store(false, memory_order_relaxed);
+			if (split->remaining.fetch_sub(1) == 1)
+				state.finish(i, split->ok.load());
+			state.group.done();
+		});
+	}
+}
+
+// Solves a chunk of small floors, deciding the tiny ones together
+// so that several of them share each vector step.
+static void solve_chunk(const vector<size_t> &chunk, BatchState &state)
+{
+	TilingContext &context = local_context();
+	vector<uint64_t> tiny;
+	vector<size_t> tinyIndex;
+	for (size_t i : chunk)
+	{
+		uint64_t cells;
+		if (load_tiny_floor(state.floors[i], cells))
+		{
+			tiny.push_back(cells);
+			tinyIndex.push_back(i);
+		}
+		else
+			state.finish(i, context.solve(state.floors[i]));
+	}
+
+	unique_ptr<bool[]> answers(new bool[tiny.size()]);
+	tiny_has_tiling(tiny.data(), tiny.size(), answers.get());
+	for (size_t k = 0; k < tiny.size(); ++k)
+		state.finish(tinyIndex[k], answers[k]);
+}
+
+vector<bool> has_tiling_batch(const vector<string_view> &floors)
+{
+	return has_tiling_batch(floors, default_pool());
+}
+
+vector<bool> has_tiling_batch(const FloorBatch &floors)
+{
+	return has_tiling_batch(floors.views(), default_pool());
+}
+
+vector<bool> has_tiling_batch(const FloorBatch &floors, ThreadPool &pool)
+{
+	return has_tiling_batch(floors.views(), pool);
+}
+
+vector<bool> has_tiling_batch(const vector<string_view> &floors, ThreadPool &pool)
+{
+	return has_tiling_batch(floors, pool, function<void(size_t, bool)>());
+}
+
+vector<bool> has_tiling_batch(const vector<string_view> &floors, ThreadPool &pool, const function<void(size_t, bool)> &onResult)
+{
+	size_t n = floors.size();
+	BatchState state;
+	state.floors = floors.data();
+	state.results.reset(new atomic<bool>[n]);
+	state.onResult = &onResult;
+
+	// First pass: measure every floor, in parallel chunks.
+	vector<double> cost(n);
+	size_t first = 0;
+	size_t bytes = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		bytes += floors[i].length();
+		if (bytes < ChunkBytes && i + 1 < n)
+			continue;
+		state.group.add();
+		pool.submit([&state, &cost, first, i]
+		{
+			for (size_t k = first; k <= i; ++k)
+				cost[k] = estimate_cost(scan_floor(state.floors[k]));
+			state.group.done();
+		});
+		first = i + 1;
+		bytes = 0;
+	}
+	state.group.wait(pool);
+
+	double total = 0;
+	for (double c : cost)
+		total += c;
+	double largeCost = total * LargeShare / pool.size();
+
+	// Second pass: the largest floors go first, each on its own task,
+	// spread over all workers but one. Every worker runs the newest
+	// task of its queue first, so each queue gets its floors in
+	// increasing order of cost.
+	vector<size_t> large;
+	for (size_t i = 0; i < n; ++i)
+		if (cost[i] >= largeCost && floors[i].length() > 0)
+			large.push_back(i);
+	sort(large.begin(), large.end(), [&cost](size_t a, size_t b) { return cost[a] < cost[b]; });
+
+	unsigned workers = pool.size();
+	unsigned dedicated = workers > 1 ? min<unsigned>(workers - 1, static_cast<unsigned>(large.size())) : 0;
+	for (size_t k = 0; k < large.size(); ++k)
+	{
+		size_t i = large[k];
+		unsigned worker = dedicated > 0 ? static_cast<unsigned>((large.size() - 1 - k) % dedicated) : 0;
+		state.group.add();
+		pool.submit_to(worker, [i, &state, &pool]
+		{
+			if (state.floors[i].length() >= SplitBytes)
+				solve_split(i, state, pool);
+			else
+				state.finish(i, local_context().solve(state.floors[i]));
+			state.group.done();
+		});
+	}
+
+	// The small floors stream through the remaining workers in chunks.
+	sort(large.begin(), large.end());
+	unsigned nextWorker = dedicated;
+	size_t nextLarge = 0;
+	vector<size_t> chunk;
+	bytes = 0;
+	auto flush = [&]()
+	{
+		if (chunk.empty())
+			return;
+		state.group.add();
+		pool.submit_to(nextWorker, [chunk, &state]
+		{
+			solve_chunk(chunk, state);
+			state.group.done();
+		});
+		nextWorker = nextWorker + 1 < workers ? nextWorker + 1 : dedicated;
+		chunk.clear();
+		bytes = 0;
+	};
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (nextLarge < large.size() && large[nextLarge] == i)
+		{
+			++nextLarge;
+			continue;
+		}
+		chunk.push_back(i);
+		bytes += floors[i].length();
+		if (bytes >= ChunkBytes)
+			flush();
+	}
+	flush();
+
+	state.group.wait(pool);
+
+	vector<bool> answers(n);
+	for (size_t i = 0; i < n; ++i)
+		answers[i] = state.results[i].load(memory_order_relaxed);
+	return answers;
+}
@@ -0,0 +1,33 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "floor_batch.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Returns whether each of the floors has a tiling, in the same order.
+//
+// The floors are solved on the pool (default_pool() if none is given),
+// each worker using its own solver context. Every floor is first
+// scanned to estimate its cost from its size and number of components.
+// The most expensive floors are then started first, each on its own
+// task, while the rest stream through the other workers in chunks, the
+// tiny floors of each chunk sharing vector registers (tiny_has_tiling).
+// Large floors are split into their connected components, which are
+// solved in parallel. The floors must stay alive and unchanged until
+// the call returns.
+vector<bool> has_tiling_batch(const vector<string_view> &floors);
+vector<bool> has_tiling_batch(const vector<string_view> &floors, ThreadPool &pool);
+vector<bool> has_tiling_batch(const FloorBatch &floors);
+vector<bool> has_tiling_batch(const FloorBatch &floors, ThreadPool &pool);
+
+// Same as above, but also calls onResult(index, answer) as soon as each
+// floor is decided, so results arrive in completion order. The calls
+// come from whichever thread solved the floor, one at a time.
+vector<bool> has_tiling_batch(const vector<string_view> &floors, ThreadPool &pool, const function<void(size_t, bool)> &onResult);
+
+#endif
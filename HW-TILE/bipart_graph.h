@@ -0,0 +1,268 @@
+#ifndef BIPARTGRAPH_H
+#define BIPARTGRAPH_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "tiling.h"
+#include "vertex.h"
+
+using namespace std;
+
+// Finds a (shortest according to edge length) augmenting path
+// from s to t in a graph with vertex set V.
+// Returns whether there is an augmenting path.
+// If stats is given, the vertices visited and edges scanned are added to it.
+bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vertex*> &P, SolveStats *stats = nullptr);
+
+// Returns the maximum flow from s to t in a weighted graph with vertex set V.
+// Assumes all edge weights are non-negative.
+// If cancel is given, it is checked before each augmentation, and once it
+// is set max_flow gives up and returns -1.
+// If stats is given, the augmentations and searches are added to it, and
+// its peakBytes is raised to the estimated size of V and its residual copy.
+int max_flow(Vertex* s, Vertex* t, unordered_set<Vertex*> V, const atomic<bool> *cancel = nullptr,
+	SolveStats *stats = nullptr);
+
+// Estimated bytes held by a graph of Vertex objects with the given
+// numbers of vertices and edges, hash table overhead included.
+size_t graph_bytes(size_t vertices, size_t edges);
+
+// The cells of a colored floor as a flow network: the source feeds every
+// black checker, each black checker leads to the red checkers next to it,
+// and every red checker drains into the sink. Used by match_floor.
+class BiPartGraph
+{
+private:
+
+	//Stores the number of vertices, used to determine the first condition in has_tiling
+	int numVertices;
+	//Stores the set with all the vertices
+	unordered_set<Vertex*> totalCheckers;
+	//Stores the set of black checkers in the bipartite graph
+	unordered_set<Vertex*> blackCheckers;
+	//Stores the set of red checkers in the bipartite graph
+	unordered_set<Vertex*> redCheckers;
+	//Stores all the vertices in the graph with their coordinates
+	unordered_map<Vertex*, pair<int, int>> vertexDictionary;
+
+	//The vertices will be used for max flow and be computed for perfect matching
+	Vertex *source;
+	Vertex *sink;
+
+
+
+	//This function connects the source to all the blac checkers
+	void setSource()
+	{
+		for (auto i : blackCheckers)
+		{
+			source->neighs.insert(i);
+			//Sets the max flow to 1
+			source->weights[i] = 1;
+		}
+		totalCheckers.insert(source);
+	}
+
+	//This function connects all the red checkers to the sink
+	void setSink()
+	{
+		for (auto i : redCheckers)
+		{
+			i->neighs.insert(sink);
+			//Sets the max flow to 1
+			i->weights[sink] = 1;
+		}
+		totalCheckers.insert(sink);
+	}
+
+
+public:
+
+	//Default constructor
+	BiPartGraph()
+	{
+		source = new Vertex();
+		sink = new Vertex();
+		numVertices = 0;
+	}
+
+	//Deletes every vertex, including the source and sink
+	~BiPartGraph()
+	{
+		totalCheckers.insert(source);
+		totalCheckers.insert(sink);
+		for (auto i : totalCheckers)
+			delete i;
+	}
+
+	BiPartGraph(const BiPartGraph&) = delete;
+	BiPartGraph& operator=(const BiPartGraph&) = delete;
+
+	//This function returns false if the two sets do not have the same number of elements
+	bool isValid()
+	{
+		if (blackCheckers.size() == redCheckers.size())
+			return true;
+		else
+			return false;
+	}
+
+	void constructGraph(const string &floor)
+	{
+		addVertices(floor);
+		addNeighbors();
+		setSource();
+		setSink();
+	}
+
+	//Adds a vertex for every open cell of a colored floor, without edges
+	void addVertices(const string &floor)
+	{
+		int row = 0;
+		int column = 0;
+
+		for (size_t i = 0; i < floor.length(); i++)
+		{
+			if (floor[i] == '#')
+				column++;
+			else if (floor[i] == '\n')
+			{
+				row++;
+				column = 0;
+			}
+			else if (floor[i] == 'b')
+			{
+				Vertex * baby = new Vertex();
+				pair<int, int> bPair;
+				bPair.first = row;
+				bPair.second = column;
+				blackCheckers.insert(baby);
+				totalCheckers.insert(baby);
+				vertexDictionary[baby] = bPair;
+				column++;
+			}
+			else
+			{
+				Vertex * baby = new Vertex();
+				pair<int, int> bPair;
+				bPair.first = row;
+				bPair.second = column;
+				redCheckers.insert(baby);
+				totalCheckers.insert(baby);
+				vertexDictionary[baby] = bPair;
+				column++;
+			}
+		}
+	}
+
+	//Joins every black checker to the red checkers next to it
+	void addNeighbors()
+	{
+		string dummy = "";
+		for (auto i : blackCheckers)
+		{
+			pair<int, int> up, down, left, right;
+			//Set up coordinates
+			up.first = vertexDictionary.at(i).first - 1;
+			up.second = vertexDictionary.at(i).second;
+			//Set down coordinates
+			down.first = vertexDictionary.at(i).first + 1;
+			down.second = vertexDictionary.at(i).second;
+			//Set left coordinates
+			left.first = vertexDictionary.at(i).first;
+			left.second = vertexDictionary.at(i).second - 1;
+			//Set right coordinates
+			right.first = vertexDictionary.at(i).first;
+			right.second = vertexDictionary.at(i).second + 1;
+
+			//Step 1: Try to search for a neighbor up
+			for (auto k : redCheckers)
+			{
+				if (vertexDictionary.at(k) == up)
+				{
+					i->neighs.insert(k);
+					i->weights[k] = 1;
+				}
+				else if (vertexDictionary.at(k) == down)
+				{
+					i->neighs.insert(k);
+					i->weights[k] = 1;
+				}
+				else if (vertexDictionary.at(k) == left)
+				{
+					i->neighs.insert(k);
+					i->weights[k] = 1;
+				}
+				else if (vertexDictionary.at(k) == right)
+				{
+					i->neighs.insert(k);
+					i->weights[k] = 1;
+				}
+			}
+		}
+	}
+
+	Vertex* GetSource()
+	{
+		return source;
+	}
+	Vertex* GetSink()
+	{
+		return sink;
+	}
+
+	//Returns every vertex, the source and sink included once the graph is constructed
+	const unordered_set<Vertex*>& GetVertices()
+	{
+		return totalCheckers;
+	}
+
+	int getFlow(const atomic<bool> *cancel = nullptr, SolveStats *stats = nullptr)
+	{
+		return max_flow(source, sink, totalCheckers, cancel, stats);
+	}
+
+	int getB()
+	{
+		return static_cast<int>(blackCheckers.size());
+	}
+
+	///Helper method to display variables
+	void displayFlow()
+	{
+		int counter = 1;
+
+		cout << "Source" << endl;
+		cout << "Neighbors: ";
+		for (auto x : source->neighs)
+			cout << vertexDictionary[x].first << "," << vertexDictionary[x].second << " :: ";
+		cout << endl;
+
+		for (auto i : vertexDictionary)
+		{
+			cout << counter << ": " << i.second.first << "," << i.second.second << endl;
+			cout << "Neighbors: ";
+			for (auto k : i.first->neighs)
+			{
+				cout << vertexDictionary[k].first << "," << vertexDictionary[k].second << " :: ";
+			}
+			counter++;
+			cout << endl;
+		}
+
+		cout << "Sink" << endl;
+		cout << "Neighbors: ";
+		for (auto y : sink->neighs)
+			cout << vertexDictionary[y].first << "," << vertexDictionary[y].second << " :: ";
+		cout << endl;
+
+		system("pause");
+	}
+};
+
+#endif // !BIPARTGRAPH_H
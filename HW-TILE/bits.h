@@ -0,0 +1,59 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Returns the number of set bits of x.
+inline int popcount64(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	return static_cast<int>(__popcnt64(x));
+#elif defined(_MSC_VER)
+	return static_cast<int>(__popcnt(static_cast<uint32_t>(x)) + __popcnt(static_cast<uint32_t>(x >> 32)));
+#else
+	return __builtin_popcountll(x);
+#endif
+}
+
+// Returns the index of the lowest set bit of x, which must not be 0.
+inline int lowest_bit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return static_cast<int>(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, static_cast<uint32_t>(x)))
+		return static_cast<int>(index);
+	_BitScanForward(&index, static_cast<uint32_t>(x >> 32));
+	return static_cast<int>(index) + 32;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+// Returns the low 64 bits of a * b, storing the high 64 bits in high.
+inline uint64_t multiply_wide(uint64_t a, uint64_t b, uint64_t &high)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return _umul128(a, b, &high);
+#elif defined(__SIZEOF_INT128__)
+	unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	high = static_cast<uint64_t>(product >> 64);
+	return static_cast<uint64_t>(product);
+#else
+	uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32, b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+	uint64_t low = a0 * b0, middle = a1 * b0 + (low >> 32), other = a0 * b1 + (middle & 0xFFFFFFFF);
+	high = a1 * b1 + (middle >> 32) + (other >> 32);
+	return (other << 32) | (low & 0xFFFFFFFF);
+#endif
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+using namespace std;
+
+// Fixed-capacity queue that any number of threads may push to and pop
+// from at once without locking.
+//
+// Every slot carries a sequence number telling whether it is ready to be
+// written or read for the current lap around the ring, so producers and
+// consumers only contend on the head or tail counter they advance.
+template <class T>
+class BoundedQueue
+{
+public:
+	// The capacity is rounded up to a power of two.
+	explicit BoundedQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+		mask = size - 1;
+		slots.reset(new Slot[size]);
+		for (size_t i = 0; i < size; ++i)
+			slots[i].sequence.store(i, memory_order_relaxed);
+		head.store(0, memory_order_relaxed);
+		tail.store(0, memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// Moves value into the queue. Returns false, leaving value
+	// untouched, if the queue is full.
+	bool try_push(T &value)
+	{
+		size_t pos = tail.load(memory_order_relaxed);
+		while (true)
+		{
+			Slot &slot = slots[pos & mask];
+			size_t seq = slot.sequence.load(memory_order_acquire);
+			if (seq == pos)
+			{
+				if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				{
+					slot.value = move(value);
+					slot.sequence.store(pos + 1, memory_order_release);
+					return true;
+				}
+			}
+			else if (seq < pos)
+				return false;
+			else
+				pos = tail.load(memory_order_relaxed);
+		}
+	}
+
+	// Moves the oldest element into value. Returns false if the queue
+	// is empty.
+	bool try_pop(T &value)
+	{
+		size_t pos = head.load(memory_order_relaxed);
+		while (true)
+		{
+			Slot &slot = slots[pos & mask];
+			size_t seq = slot.sequence.load(memory_order_acquire);
+			if (seq == pos + 1)
+			{
+				if (head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+				{
+					value = move(slot.value);
+					slot.sequence.store(pos + mask + 1, memory_order_release);
+					return true;
+				}
+			}
+			else if (seq < pos + 1)
+				return false;
+			else
+				pos = head.load(memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		atomic<size_t> sequence;
+		T value;
+	};
+
+	unique_ptr<Slot[]> slots;
+	size_t mask;
+
+	// Producers and consumers advance different counters, kept on
+	// separate cache lines.
+	alignas(64) atomic<size_t> tail;
+	alignas(64) atomic<size_t> head;
+};
+
+#endif
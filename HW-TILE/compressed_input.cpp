@@ -0,0 +1,351 @@
+#ifdef HW_TILE_ZLIB
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <zlib.h>
+#include "compressed_input.h"
+
+using namespace std;
+
+// Uncompressed bytes per BGZF block written, and the most a block may
+// hold.
+static const size_t BlockInput = 0xFF00;
+static const size_t BlockLimit = 0x10000;
+// Bytes inflated or copied per refill when not reading BGZF blocks.
+static const size_t StreamChunk = 256 * 1024;
+
+// The empty block that ends a BGZF file.
+static const unsigned char EndOfFile[28] = {
+	0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+struct CompressedFloorReader::Block
+{
+	string text;
+	bool ok = false;
+	TaskGroup group;
+};
+
+struct CompressedFloorReader::Stream
+{
+	z_stream zs;
+	// Bytes of the file handed to zlib so far; zlib counts in 32 bits.
+	size_t fed = 0;
+	bool ended = false;
+};
+
+// Inflates one whole BGZF block, whose last four bytes give its
+// uncompressed size. A block claiming more than BGZF allows is corrupt,
+// and is rejected before any room is made for it.
+static bool inflate_member(const unsigned char *member, size_t size, string &text)
+{
+	const unsigned char *tail = member + size - 4;
+	size_t length = tail[0] | (tail[1] << 8) | (tail[2] << 16) | (size_t(tail[3]) << 24);
+	if (length > BlockLimit)
+		return false;
+	text.resize(length);
+
+	z_stream zs = {};
+	if (inflateInit2(&zs, 15 + 16) != Z_OK)
+		return false;
+	zs.next_in = const_cast<unsigned char*>(member);
+	zs.avail_in = static_cast<uInt>(size);
+	zs.next_out = reinterpret_cast<unsigned char*>(&text[0]);
+	zs.avail_out = static_cast<uInt>(text.size());
+	int status = inflate(&zs, Z_FINISH);
+	inflateEnd(&zs);
+	return status == Z_STREAM_END && zs.avail_out == 0;
+}
+
+CompressedFloorReader::CompressedFloorReader(const string &path, ThreadPool &pool, size_t window)
+	: pool(pool), failed(false), nextBlock(0), window(window ? window : 2 * pool.size()),
+	plainAt(0), taken(0), scanned(0), finished(false)
+{
+	if (!file.open(path))
+	{
+		failed = true;
+		return;
+	}
+
+	string_view data = file.view();
+	bool gzip = data.size() >= 2 && static_cast<unsigned char>(data[0]) == 0x1f && static_cast<unsigned char>(data[1]) == 0x8b;
+	if (!gzip || find_blocks())
+		return;
+
+	blocks.clear();
+	stream = make_unique<Stream>();
+	stream->zs = z_stream();
+	if (inflateInit2(&stream->zs, 15 + 16) != Z_OK)
+	{
+		cerr << "CompressedFloorReader could not start zlib." << endl;
+		failed = true;
+		return;
+	}
+}
+
+CompressedFloorReader::~CompressedFloorReader()
+{
+	// Blocks still inflating refer to the mapping.
+	for (shared_ptr<Block> &block : ahead)
+		block->group.wait(pool);
+	if (stream)
+		inflateEnd(&stream->zs);
+}
+
+bool CompressedFloorReader::ok() const
+{
+	return !failed;
+}
+
+bool CompressedFloorReader::find_blocks()
+{
+	string_view data = file.view();
+	const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data.data());
+	size_t at = 0;
+	while (at < data.size())
+	{
+		size_t left = data.size() - at;
+		const unsigned char *header = bytes + at;
+		if (left < 18 || header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || !(header[3] & 4))
+			return false;
+		size_t extra = header[10] | (header[11] << 8);
+		if (12 + extra > left)
+			return false;
+
+		// Look for the BC subfield holding the block size.
+		size_t size = 0;
+		for (size_t k = 12; k + 4 <= 12 + extra;)
+		{
+			size_t length = header[k + 2] | (header[k + 3] << 8);
+			if (header[k] == 'B' && header[k + 1] == 'C' && length == 2 && k + 6 <= 12 + extra)
+				size = (header[k + 4] | (header[k + 5] << 8)) + size_t(1);
+			k += 4 + length;
+		}
+		if (size < 18 + 8 || size > left)
+			return false;
+		blocks.emplace_back(at, size);
+		at += size;
+	}
+	return !blocks.empty();
+}
+
+bool CompressedFloorReader::refill()
+{
+	buffer.erase(0, taken);
+	scanned -= taken;
+	taken = 0;
+	string_view data = file.view();
+
+	if (!blocks.empty())
+	{
+		// Keep the window of blocks being inflated full.
+		auto topUp = [this, data]()
+		{
+			while (ahead.size() < window && nextBlock < blocks.size())
+			{
+				auto block = make_shared<Block>();
+				block->group.add();
+				const unsigned char *member = reinterpret_cast<const unsigned char*>(data.data()) + blocks[nextBlock].first;
+				size_t size = blocks[nextBlock].second;
+				pool.submit([block, member, size]
+				{
+					block->ok = inflate_member(member, size, block->text);
+					block->group.done();
+				});
+				ahead.push_back(block);
+				nextBlock++;
+			}
+		};
+		topUp();
+		if (ahead.empty())
+			return false;
+
+		shared_ptr<Block> block = ahead.front();
+		ahead.pop_front();
+		topUp();
+		block->group.wait(pool);
+		if (!block->ok)
+		{
+			cerr << "CompressedFloorReader found a corrupt block." << endl;
+			failed = true;
+			return false;
+		}
+		buffer += block->text;
+		return true;
+	}
+
+	if (stream)
+	{
+		z_stream &zs = stream->zs;
+		if (stream->ended)
+			return false;
+		if (zs.avail_in == 0 && stream->fed < data.size())
+		{
+			size_t length = min(data.size() - stream->fed, size_t(1) << 30);
+			zs.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data.data() + stream->fed));
+			zs.avail_in = static_cast<uInt>(length);
+			stream->fed += length;
+		}
+		size_t have = buffer.size();
+		buffer.resize(have + StreamChunk);
+		zs.next_out = reinterpret_cast<unsigned char*>(&buffer[have]);
+		zs.avail_out = static_cast<uInt>(StreamChunk);
+		int status = inflate(&zs, Z_NO_FLUSH);
+		buffer.resize(have + StreamChunk - zs.avail_out);
+		if (status == Z_STREAM_END)
+		{
+			// Another member may follow.
+			if (zs.avail_in > 0 || stream->fed < data.size())
+				inflateReset(&zs);
+			else
+				stream->ended = true;
+		}
+		else if (status != Z_OK)
+		{
+			cerr << "CompressedFloorReader found corrupt data." << endl;
+			failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	if (plainAt >= data.size())
+		return false;
+	size_t length = min(StreamChunk, data.size() - plainAt);
+	buffer.append(data.data() + plainAt, length);
+	plainAt += length;
+	return true;
+}
+
+// Returns whether the line starting at buffer[at] and ending at end is blank.
+static bool blank_line(const string &buffer, size_t at, size_t end)
+{
+	return end == at || (end == at + 1 && buffer[at] == '\r');
+}
+
+bool CompressedFloorReader::take_floor(string &floor)
+{
+	size_t end;
+	while ((end = buffer.find('\n', taken)) != string::npos && blank_line(buffer, taken, end))
+		taken = end + 1;
+	scanned = max(scanned, taken);
+
+	while ((end = buffer.find('\n', scanned)) != string::npos)
+	{
+		if (scanned > taken && blank_line(buffer, scanned, end))
+		{
+			floor.assign(buffer, taken, scanned - taken);
+			taken = scanned = end + 1;
+			return true;
+		}
+		scanned = end + 1;
+	}
+
+	// The last floor need not be followed by a blank line.
+	if (finished && taken < buffer.size())
+	{
+		floor.assign(buffer, taken, string::npos);
+		if (floor.back() != '\n')
+			floor += '\n';
+		taken = scanned = buffer.size();
+		return floor.find_first_not_of("\r\n") != string::npos;
+	}
+	return false;
+}
+
+bool CompressedFloorReader::next(string &floor)
+{
+	while (!failed)
+	{
+		if (take_floor(floor))
+			return true;
+		if (finished)
+			return false;
+		if (!refill())
+			finished = true;
+	}
+	return false;
+}
+
+// Appends one BGZF block holding text to out.
+static void append_block(string_view text, int level, string &out)
+{
+	z_stream zs = {};
+	deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	string packed(deflateBound(&zs, static_cast<uLong>(text.size())), '\0');
+	zs.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(text.data()));
+	zs.avail_in = static_cast<uInt>(text.size());
+	zs.next_out = reinterpret_cast<unsigned char*>(&packed[0]);
+	zs.avail_out = static_cast<uInt>(packed.size());
+	deflate(&zs, Z_FINISH);
+	packed.resize(zs.total_out);
+	deflateEnd(&zs);
+
+	uLong crc = crc32(0, reinterpret_cast<const unsigned char*>(text.data()), static_cast<uInt>(text.size()));
+	size_t blockSize = 18 + packed.size() + 8;
+	unsigned char header[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+		static_cast<unsigned char>((blockSize - 1) & 0xFF), static_cast<unsigned char>((blockSize - 1) >> 8) };
+	out.append(reinterpret_cast<const char*>(header), sizeof(header));
+	out += packed;
+	for (uint32_t value : { static_cast<uint32_t>(crc), static_cast<uint32_t>(text.size()) })
+		for (int k = 0; k < 4; ++k)
+			out += static_cast<char>((value >> (8 * k)) & 0xFF);
+}
+
+bool write_compressed(const string &path, const vector<string_view> &floors, int level)
+{
+	ofstream file(path, ios::binary);
+	if (!file)
+	{
+		cerr << "write_compressed() could not open " << path << "." << endl;
+		return false;
+	}
+
+	string text;
+	string out;
+	auto flush = [&](bool all)
+	{
+		size_t at = 0;
+		while (text.size() - at >= BlockInput || (all && at < text.size()))
+		{
+			size_t length = min(BlockInput, text.size() - at);
+			append_block(string_view(text).substr(at, length), level, out);
+			at += length;
+		}
+		text.erase(0, at);
+		file.write(out.data(), out.size());
+		out.clear();
+	};
+	for (string_view floor : floors)
+	{
+		text += floor;
+		if (floor.empty() || floor.back() != '\n')
+			text += '\n';
+		text += '\n';
+		if (text.size() >= BlockInput)
+			flush(false);
+	}
+	flush(true);
+	file.write(reinterpret_cast<const char*>(EndOfFile), sizeof(EndOfFile));
+	return static_cast<bool>(file);
+}
+
+size_t solve_compressed(const string &path, const function<void(size_t, bool)> &onResult, const PipelineOptions &options)
+{
+	CompressedFloorReader reader(path);
+	if (!reader.ok())
+		return 0;
+	size_t count = 0;
+	run_pipeline([&](string &floor)
+	{
+		if (!reader.next(floor))
+			return false;
+		count++;
+		return true;
+	}, onResult, options);
+	return count;
+}
+
+#endif
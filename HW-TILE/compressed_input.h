@@ -0,0 +1,91 @@
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+
+// Needs zlib; define HW_TILE_ZLIB and link against it to build this
+// (make ZLIB=1, or msbuild /p:UseZlib=true).
+#ifdef HW_TILE_ZLIB
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Reads floors separated by blank lines from a gzip file, decompressing
+// as it goes, so the whole uncompressed archive never exists at once.
+//
+// A file made of BGZF blocks (gzip members that record their own size,
+// as written by write_compressed or bgzip) is inflated block by block on
+// the pool, several blocks ahead of the reader, so decompression runs in
+// parallel and overlaps with whatever consumes the floors. Any other
+// gzip file is inflated on the reading thread, and a file that isn't
+// gzip at all is read as plain text.
+class CompressedFloorReader
+{
+public:
+	// Maps the file. window is the number of blocks inflated ahead of the
+	// reader; 0 means twice the pool's size.
+	explicit CompressedFloorReader(const string &path, ThreadPool &pool = default_pool(), size_t window = 0);
+	~CompressedFloorReader();
+
+	CompressedFloorReader(const CompressedFloorReader&) = delete;
+	CompressedFloorReader& operator=(const CompressedFloorReader&) = delete;
+
+	// Returns false if the file couldn't be mapped or turned out to be
+	// corrupt; an error has been printed.
+	bool ok() const;
+
+	// Gets the next floor. Returns false once there are none left.
+	bool next(string &floor);
+
+private:
+	struct Block;
+	struct Stream;
+
+	MappedFile file;
+	ThreadPool &pool;
+	bool failed;
+
+	// BGZF blocks, as offset and size in the file.
+	vector<pair<size_t, size_t>> blocks;
+	size_t nextBlock;
+	size_t window;
+	deque<shared_ptr<Block>> ahead;
+
+	// Inflater for files that aren't BGZF.
+	unique_ptr<Stream> stream;
+	size_t plainAt;
+
+	// Decoded text not yet handed out, starting at buffer[taken].
+	string buffer;
+	size_t taken;
+	// Where the search for the blank line ending the next floor resumes.
+	size_t scanned;
+	bool finished;
+
+	bool find_blocks();
+	bool refill();
+	bool take_floor(string &floor);
+};
+
+// Writes floors to path as BGZF blocks, each floor followed by a blank
+// line, so that CompressedFloorReader can inflate it in parallel.
+// Prints an error and returns false if the file can't be written.
+bool write_compressed(const string &path, const vector<string_view> &floors, int level = 6);
+
+// Decides every floor of a compressed file with run_pipeline, reporting
+// the i-th floor as onResult(i, answer). Returns the number of floors, or
+// 0 after printing an error if the file is unreadable.
+size_t solve_compressed(const string &path, const function<void(size_t, bool)> &onResult,
+	const PipelineOptions &options = PipelineOptions());
+
+#endif
+
+#endif
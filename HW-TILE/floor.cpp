@@ -0,0 +1,169 @@
+#include <algorithm>
+#include "floor.h"
+
+using namespace std;
+
+// Returns the representative of x, halving paths along the way.
+static int find_root(vector<int> &parent, int x)
+{
+	while (parent[x] != x)
+	{
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+FloorInfo scan_floor(string_view floor)
+{
+	FloorInfo info = { 0, 0, 0, 0 };
+
+	// Labels of the open cells of the previous and current row, -1 for walls.
+	vector<int> above, current;
+	// Union-find over the labels; merging two labels retires one component.
+	vector<int> parent;
+
+	size_t begin = 0;
+	while (begin < floor.length())
+	{
+		size_t end = floor.find('\n', begin);
+		if (end == string_view::npos)
+			end = floor.length();
+		int length = static_cast<int>(end - begin);
+		info.width = max(info.width, length);
+		info.rows++;
+
+		current.assign(length, -1);
+		for (int c = 0; c < length; ++c)
+		{
+			if (floor[begin + c] != ' ')
+				continue;
+			info.openCells++;
+
+			int left = c > 0 ? current[c - 1] : -1;
+			int up = c < static_cast<int>(above.size()) ? above[c] : -1;
+			if (left == -1 && up == -1)
+			{
+				current[c] = static_cast<int>(parent.size());
+				parent.push_back(current[c]);
+				info.components++;
+				continue;
+			}
+			if (left == -1 || up == -1)
+			{
+				current[c] = left == -1 ? up : left;
+				continue;
+			}
+
+			int a = find_root(parent, left);
+			int b = find_root(parent, up);
+			if (a != b)
+			{
+				parent[b] = a;
+				info.components--;
+			}
+			current[c] = a;
+		}
+
+		swap(above, current);
+		begin = end + 1;
+	}
+
+	return info;
+}
+
+double estimate_cost(const FloorInfo &info)
+{
+	// Every cell is read once, and the matching grows roughly with
+	// the square of the size of each component.
+	double cells = static_cast<double>(info.rows) * info.width;
+	double open = static_cast<double>(info.openCells);
+	double perComponent = info.components > 0 ? open / info.components : 0.0;
+	return cells + open * perComponent;
+}
+
+vector<string> split_components(string_view floor)
+{
+	// Find where every line starts so that cells can be addressed by row.
+	vector<size_t> lineStart;
+	int width = 0;
+	size_t begin = 0;
+	while (begin < floor.length())
+	{
+		size_t end = floor.find('\n', begin);
+		if (end == string_view::npos)
+			end = floor.length();
+		lineStart.push_back(begin);
+		width = max(width, static_cast<int>(end - begin));
+		begin = end + 1;
+	}
+	lineStart.push_back(floor.length() + 1);
+
+	int rows = static_cast<int>(lineStart.size()) - 1;
+
+	auto isOpen = [&](int r, int c)
+	{
+		if (r < 0 || r >= rows || c < 0)
+			return false;
+		size_t at = lineStart[r] + c;
+		return at + 1 < lineStart[r + 1] && floor[at] == ' ';
+	};
+
+	// Label every open cell with its component, -1 meaning unvisited.
+	vector<int> label(static_cast<size_t>(rows) * width, -1);
+	vector<string> components;
+	vector<pair<int, int>> stack;
+	vector<pair<int, int>> cells;
+
+	for (int r = 0; r < rows; ++r)
+		for (int c = 0; c < width; ++c)
+		{
+			if (!isOpen(r, c) || label[static_cast<size_t>(r) * width + c] != -1)
+				continue;
+
+			int id = static_cast<int>(components.size());
+			int top = r, bottom = r, left = c, right = c;
+			cells.clear();
+			stack.push_back(make_pair(r, c));
+			label[static_cast<size_t>(r) * width + c] = id;
+
+			while (!stack.empty())
+			{
+				pair<int, int> cur = stack.back();
+				stack.pop_back();
+				cells.push_back(cur);
+				top = min(top, cur.first);
+				bottom = max(bottom, cur.first);
+				left = min(left, cur.second);
+				right = max(right, cur.second);
+
+				const int dr[4] = { -1, 1, 0, 0 };
+				const int dc[4] = { 0, 0, -1, 1 };
+				for (int d = 0; d < 4; ++d)
+				{
+					int nr = cur.first + dr[d];
+					int nc = cur.second + dc[d];
+					if (!isOpen(nr, nc) || label[static_cast<size_t>(nr) * width + nc] != -1)
+						continue;
+					label[static_cast<size_t>(nr) * width + nc] = id;
+					stack.push_back(make_pair(nr, nc));
+				}
+			}
+
+			// Draw the component inside a wall border.
+			int boxWidth = right - left + 3;
+			int boxHeight = bottom - top + 3;
+			string out(static_cast<size_t>(boxWidth + 1) * boxHeight, '#');
+			for (int i = 0; i < boxHeight; ++i)
+				out[static_cast<size_t>(i) * (boxWidth + 1) + boxWidth] = '\n';
+			for (pair<int, int> cell : cells)
+			{
+				int i = cell.first - top + 1;
+				int j = cell.second - left + 1;
+				out[static_cast<size_t>(i) * (boxWidth + 1) + j] = ' ';
+			}
+			components.push_back(move(out));
+		}
+
+	return components;
+}
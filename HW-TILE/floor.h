@@ -0,0 +1,37 @@
+#ifndef FLOOR_H
+#define FLOOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Shape of a floor, gathered in one pass over its text.
+struct FloorInfo
+{
+	// Number of lines.
+	int rows;
+	// Length of the longest line.
+	int width;
+	// Number of open cells.
+	long long openCells;
+	// Number of connected groups of open cells.
+	long long components;
+};
+
+// Scans the floor once, labeling only two rows of cells at a time.
+FloorInfo scan_floor(string_view floor);
+
+// Returns a rough relative cost of solving a floor with the given shape.
+double estimate_cost(const FloorInfo &info);
+
+// Splits a floor into its connected groups of open cells.
+//
+// Each group is returned as a floor of its own, cropped to the group's
+// bounding box plus a border of walls. A floor has a tiling exactly
+// when every one of its groups does, so the groups can be solved
+// independently.
+vector<string> split_components(string_view floor);
+
+#endif
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "floor_batch.h"
+
+using namespace std;
+
+FloorBatch::FloorBatch()
+	: offsets(1, 0), withDims(true)
+{
+}
+
+void FloorBatch::reserve(size_t floors, size_t bytes)
+{
+	arena.reserve(bytes);
+	offsets.reserve(floors + 1);
+	if (withDims)
+		dims.reserve(2 * floors);
+}
+
+void FloorBatch::add(string_view floor)
+{
+	arena.append(floor.data(), floor.length());
+	offsets.push_back(arena.length());
+	withDims = false;
+	dims.clear();
+}
+
+void FloorBatch::add(string_view floor, int rows, int width)
+{
+	arena.append(floor.data(), floor.length());
+	offsets.push_back(arena.length());
+	if (withDims)
+	{
+		dims.push_back(rows);
+		dims.push_back(width);
+	}
+}
+
+void FloorBatch::clear()
+{
+	arena.clear();
+	offsets.resize(1);
+	dims.clear();
+	withDims = true;
+}
+
+size_t FloorBatch::size() const
+{
+	return offsets.size() - 1;
+}
+
+string_view FloorBatch::operator[](size_t i) const
+{
+	return string_view(arena.data() + offsets[i], offsets[i + 1] - offsets[i]);
+}
+
+bool FloorBatch::has_dimensions() const
+{
+	return withDims;
+}
+
+int FloorBatch::rows(size_t i) const
+{
+	return dims[2 * i];
+}
+
+int FloorBatch::width(size_t i) const
+{
+	return dims[2 * i + 1];
+}
+
+vector<string_view> FloorBatch::views() const
+{
+	vector<string_view> all;
+	all.reserve(size());
+	for (size_t i = 0; i < size(); ++i)
+		all.push_back((*this)[i]);
+	return all;
+}
+
+size_t read_floors(istream &in, FloorBatch &batch)
+{
+	// Read the whole stream onto the end of the arena, in large blocks.
+	size_t start = batch.arena.length();
+	const size_t Block = 1 << 20;
+	while (in)
+	{
+		size_t have = batch.arena.length();
+		batch.arena.resize(have + Block);
+		in.read(&batch.arena[have], Block);
+		batch.arena.resize(have + static_cast<size_t>(in.gcount()));
+	}
+
+	if (batch.arena.length() > start && batch.arena.back() != '\n')
+		batch.arena.push_back('\n');
+
+	// Squeeze out the blank lines in place; floors only move backwards.
+	size_t end = batch.arena.length();
+	size_t out = start;
+	int rows = 0;
+	int width = 0;
+	size_t before = batch.size();
+
+	auto finishFloor = [&]()
+	{
+		if (rows == 0)
+			return;
+		batch.offsets.push_back(out);
+		if (batch.withDims)
+		{
+			batch.dims.push_back(rows);
+			batch.dims.push_back(width);
+		}
+		rows = 0;
+		width = 0;
+	};
+
+	size_t at = start;
+	while (at < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(batch.arena.data() + at, '\n', end - at));
+		size_t next = static_cast<size_t>(lineEnd - batch.arena.data()) + 1;
+		size_t length = next - at;
+		size_t content = length - 1;
+		if (content > 0 && batch.arena[at + content - 1] == '\r')
+			content--;
+
+		if (content == 0)
+			finishFloor();
+		else
+		{
+			memmove(&batch.arena[out], batch.arena.data() + at, length);
+			out += length;
+			rows++;
+			width = max(width, static_cast<int>(content));
+		}
+		at = next;
+	}
+	batch.arena.resize(out);
+	finishFloor();
+
+	return batch.size() - before;
+}
+
+size_t read_sized_floors(istream &in, FloorBatch &batch)
+{
+	size_t before = batch.size();
+	string line;
+	string floor;
+	while (getline(in, line))
+	{
+		if (line.empty() || line == "\r")
+			continue;
+
+		char* end;
+		unsigned long long length = strtoull(line.c_str(), &end, 10);
+		if (end == line.c_str() || (*end != '\0' && *end != '\r'))
+		{
+			cerr << "read_sized_floors() expected a length, got \"" << line << "\"." << endl;
+			break;
+		}
+		floor.resize(static_cast<size_t>(length));
+		in.read(&floor[0], static_cast<streamsize>(length));
+		if (static_cast<unsigned long long>(in.gcount()) != length)
+		{
+			cerr << "read_sized_floors() found a floor cut short." << endl;
+			break;
+		}
+
+		int rows = 0;
+		int width = 0;
+		size_t begin = 0;
+		while (begin < floor.length())
+		{
+			size_t lineEnd = floor.find('\n', begin);
+			if (lineEnd == string::npos)
+				lineEnd = floor.length();
+			size_t content = lineEnd - begin;
+			if (content > 0 && floor[lineEnd - 1] == '\r')
+				content--;
+			width = max(width, static_cast<int>(content));
+			rows++;
+			begin = lineEnd + 1;
+		}
+		batch.add(floor, rows, width);
+	}
+	return batch.size() - before;
+}
+
+size_t split_floors(string_view text, vector<string_view> &floors)
+{
+	size_t before = floors.size();
+	size_t begin = string_view::npos;
+	size_t at = 0;
+	while (at < text.length())
+	{
+		size_t lineEnd = text.find('\n', at);
+		size_t next = lineEnd == string_view::npos ? text.length() : lineEnd + 1;
+		size_t content = (lineEnd == string_view::npos ? text.length() : lineEnd) - at;
+		bool blank = content == 0 || (content == 1 && text[at] == '\r');
+
+		if (blank && begin != string_view::npos)
+		{
+			floors.push_back(text.substr(begin, at - begin));
+			begin = string_view::npos;
+		}
+		else if (!blank && begin == string_view::npos)
+			begin = at;
+		at = next;
+	}
+	if (begin != string_view::npos)
+		floors.push_back(text.substr(begin));
+	return floors.size() - before;
+}
+
+size_t split_sized_floors(string_view text, vector<string_view> &floors)
+{
+	size_t before = floors.size();
+	size_t at = 0;
+	while (at < text.length())
+	{
+		if (text[at] == '\n' || text[at] == '\r')
+		{
+			at++;
+			continue;
+		}
+
+		unsigned long long length = 0;
+		size_t digits = at;
+		while (digits < text.length() && text[digits] >= '0' && text[digits] <= '9')
+			length = length * 10 + (text[digits++] - '0');
+		if (digits < text.length() && text[digits] == '\r')
+			digits++;
+		if (digits == at || digits >= text.length() || text[digits] != '\n')
+		{
+			cerr << "split_sized_floors() expected a length at byte " << at << "." << endl;
+			break;
+		}
+		at = digits + 1;
+		if (length > text.length() - at)
+		{
+			cerr << "split_sized_floors() found a floor cut short." << endl;
+			break;
+		}
+		floors.push_back(text.substr(at, static_cast<size_t>(length)));
+		at += static_cast<size_t>(length);
+	}
+	return floors.size() - before;
+}
+
+size_t load_floors(const string &path, FloorBatch &batch)
+{
+	ifstream in(path, ios::binary);
+	if (!in)
+	{
+		cerr << "load_floors() could not open " << path << "." << endl;
+		return 0;
+	}
+	return read_floors(in, batch);
+}
@@ -0,0 +1,87 @@
+#ifndef FLOOR_BATCH_H
+#define FLOOR_BATCH_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Many floors stored back to back in one buffer.
+//
+// Floor i occupies bytes offsets[i] to offsets[i + 1] of the arena, so
+// a batch of a million floors needs three allocations rather than a
+// million strings. Floors may also carry their dimensions when the code
+// that added them already knew them.
+class FloorBatch
+{
+public:
+	FloorBatch();
+
+	// Makes room for the given number of floors and total bytes.
+	void reserve(size_t floors, size_t bytes);
+
+	// Appends a copy of the floor.
+	void add(string_view floor);
+
+	// Appends a copy of the floor along with its dimensions.
+	void add(string_view floor, int rows, int width);
+
+	// Removes every floor, keeping the allocated memory.
+	void clear();
+
+	// Returns the number of floors.
+	size_t size() const;
+
+	// Returns floor i. The view stays valid until the batch changes.
+	string_view operator[](size_t i) const;
+
+	// Returns whether every floor was added with its dimensions.
+	bool has_dimensions() const;
+
+	// Returns the dimensions of floor i, if has_dimensions().
+	int rows(size_t i) const;
+	int width(size_t i) const;
+
+	// Returns a view of every floor, in order.
+	vector<string_view> views() const;
+
+	// Gives the loaders direct access to the buffers.
+	friend size_t read_floors(istream &in, FloorBatch &batch);
+
+private:
+	string arena;
+	vector<size_t> offsets;
+	// Rows and width of each floor, kept only while every floor has them.
+	vector<int> dims;
+	bool withDims;
+};
+
+// Reads floors separated by blank lines from the stream and appends them
+// to the batch, with their dimensions. Each floor keeps the newline that
+// ends its last line. Returns the number of floors read.
+size_t read_floors(istream &in, FloorBatch &batch);
+
+// Reads length-prefixed floors from the stream and appends them to the
+// batch, with their dimensions. Each floor is a line holding its length
+// in bytes, in decimal, followed by exactly that many bytes; blank lines
+// between floors are skipped. Floors may then contain blank lines of
+// their own. Returns the number of floors read, stopping with an error
+// message at the first malformed or truncated one.
+size_t read_sized_floors(istream &in, FloorBatch &batch);
+
+// Finds the floors of text without copying them, as views into text,
+// appending them to floors. split_floors expects floors separated by blank
+// lines, as read_floors does, and split_sized_floors length-prefixed ones,
+// as read_sized_floors does. Meant for text that is already in memory,
+// such as a MappedFile. Both return the number of floors found.
+size_t split_floors(string_view text, vector<string_view> &floors);
+size_t split_sized_floors(string_view text, vector<string_view> &floors);
+
+// Reads every floor of a file as read_floors does. Returns the number of
+// floors read; prints an error and returns 0 if the file can't be opened.
+size_t load_floors(const string &path, FloorBatch &batch);
+
+#endif
@@ -0,0 +1,268 @@
+#include <utility>
+#include <vector>
+#include "floor_gen.h"
+
+using namespace std;
+
+FloorRandom::FloorRandom(uint64_t seed)
+	: state(seed)
+{
+}
+
+uint64_t FloorRandom::next()
+{
+	// splitmix64.
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+uint64_t FloorRandom::below(uint64_t n)
+{
+	return next() % n;
+}
+
+bool FloorRandom::chance(double p)
+{
+	return (next() >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+// A floor being generated, as text with a wall all around.
+class Drawing
+{
+public:
+	Drawing(size_t rows, size_t columns)
+		: rows(rows), columns(columns)
+	{
+		text.reserve(rows * (columns + 1));
+		for (size_t r = 0; r < rows; ++r)
+		{
+			text.append(columns, '#');
+			text += '\n';
+		}
+	}
+
+	char& at(size_t r, size_t c)
+	{
+		return text[r * (columns + 1) + c];
+	}
+
+	// Opens every cell inside the wall.
+	void open_inside()
+	{
+		for (size_t r = 1; r + 1 < rows; ++r)
+			for (size_t c = 1; c + 1 < columns; ++c)
+				at(r, c) = ' ';
+	}
+
+	const size_t rows;
+	const size_t columns;
+	string text;
+};
+
+string open_room(size_t rows, size_t columns)
+{
+	Drawing floor(rows, columns);
+	floor.open_inside();
+	return move(floor.text);
+}
+
+string random_maze(size_t rows, size_t columns, double walls, FloorRandom &random)
+{
+	Drawing floor(rows, columns);
+	for (size_t r = 1; r + 1 < rows; ++r)
+		for (size_t c = 1; c + 1 < columns; ++c)
+			if (!random.chance(walls))
+				floor.at(r, c) = ' ';
+	return move(floor.text);
+}
+
+string domino_maze(size_t rows, size_t columns, bool tileable, FloorRandom &random)
+{
+	Drawing floor(rows, columns);
+	for (size_t r = 1; r + 1 < rows; ++r)
+	{
+		size_t hole = 1 + random.below(columns - 3);
+		floor.at(r, hole) = ' ';
+		floor.at(r, hole + 1) = ' ';
+	}
+	if (tileable)
+		return move(floor.text);
+
+	size_t bad = 1 + random.below(rows - 3);
+	size_t start = 1;
+	while (floor.at(bad, start) == ' ')
+		++start;
+	floor.at(bad, start) = ' ';
+	size_t end = columns - 2;
+	while (floor.at(bad, end) == ' ')
+		--end;
+	floor.at(bad, end) = ' ';
+	return move(floor.text);
+}
+
+// Directions from a cell to its mate in a tiling.
+enum Mate : unsigned char
+{
+	Right,
+	Down,
+	Left,
+	Up
+};
+
+string tiled_floor(size_t rows, size_t columns, double holes, FloorRandom &random)
+{
+	Drawing floor(rows, columns);
+	size_t height = rows - 2;
+	size_t width = columns - 2;
+	if (height % 2 == 1 && width % 2 == 1)
+		width--;
+	if (height == 0 || width == 0)
+		return move(floor.text);
+
+	// Start from rows of bricks, or columns of them if the width is odd.
+	vector<Mate> mate(height * width);
+	for (size_t r = 0; r < height; ++r)
+		for (size_t c = 0; c < width; ++c)
+			if (width % 2 == 0)
+				mate[r * width + c] = c % 2 == 0 ? Right : Left;
+			else
+				mate[r * width + c] = r % 2 == 0 ? Down : Up;
+
+	// Turn random 2 by 2 squares made of two parallel dominoes.
+	if (height > 1 && width > 1)
+		for (size_t flips = 4 * height * width; flips > 0; --flips)
+		{
+			size_t r = random.below(height - 1), c = random.below(width - 1);
+			size_t a = r * width + c, b = a + 1, d = a + width, e = d + 1;
+			if (mate[a] == Right && mate[d] == Right)
+			{
+				mate[a] = mate[b] = Down;
+				mate[d] = mate[e] = Up;
+			}
+			else if (mate[a] == Down && mate[b] == Down)
+			{
+				mate[a] = mate[d] = Right;
+				mate[b] = mate[e] = Left;
+			}
+		}
+
+	floor.open_inside();
+	for (size_t r = 0; r < height; ++r)
+		floor.at(r + 1, width + 1) = '#';
+	for (size_t r = 0; r < height; ++r)
+		for (size_t c = 0; c < width; ++c)
+		{
+			Mate m = mate[r * width + c];
+			if ((m == Right || m == Down) && random.chance(holes))
+			{
+				floor.at(r + 1, c + 1) = '#';
+				if (m == Right)
+					floor.at(r + 1, c + 2) = '#';
+				else
+					floor.at(r + 2, c + 1) = '#';
+			}
+		}
+	return move(floor.text);
+}
+
+string near_miss(size_t rows, size_t columns, double holes, FloorRandom &random)
+{
+	string text = tiled_floor(rows, columns, holes, random);
+	vector<size_t> open[2];
+	for (size_t r = 0; r < rows; ++r)
+		for (size_t c = 0; c < columns; ++c)
+			if (text[r * (columns + 1) + c] == ' ')
+				open[(r + c) % 2].push_back(r * (columns + 1) + c);
+
+	int color = open[0].size() >= 2 ? 0 : 1;
+	if (open[color].size() >= 2)
+	{
+		size_t i = random.below(open[color].size());
+		size_t j = random.below(open[color].size() - 1);
+		if (j >= i)
+			j++;
+		text[open[color][i]] = '#';
+		text[open[color][j]] = '#';
+	}
+	else if (!open[0].empty() || !open[1].empty())
+		text[open[0].empty() ? open[1][0] : open[0][0]] = '#';
+	else
+		text[columns + 2] = ' ';
+	return text;
+}
+
+string holey_floor(size_t rows, size_t columns, double holes, FloorRandom &random)
+{
+	Drawing floor(rows, columns);
+	floor.open_inside();
+	for (size_t r = 1; r + 1 < rows; ++r)
+		for (size_t c = 1; c + 1 < columns; ++c)
+		{
+			if (!random.chance(holes))
+				continue;
+			size_t height = 1 + random.below(3), width = 1 + random.below(3);
+			for (size_t i = r; i < r + height && i + 1 < rows; ++i)
+				for (size_t j = c; j < c + width && j + 1 < columns; ++j)
+					floor.at(i, j) = '#';
+		}
+	return move(floor.text);
+}
+
+string long_strip(size_t length, size_t width, double walls, FloorRandom &random)
+{
+	return random_maze(length + 2, width + 2, walls, random);
+}
+
+string aztec_diamond(size_t order)
+{
+	Drawing floor(2 * order + 2, 2 * order + 2);
+	for (size_t r = 0; r < 2 * order; ++r)
+	{
+		size_t half = r < order ? r + 1 : 2 * order - r;
+		for (size_t c = order - half; c < order + half; ++c)
+			floor.at(r + 1, c + 1) = ' ';
+	}
+	return move(floor.text);
+}
+
+string pillar_room(size_t rows, size_t columns)
+{
+	Drawing floor(rows, columns);
+	floor.open_inside();
+	for (size_t r = 1; r + 1 < rows; ++r)
+		for (size_t c = 1; c + 1 < columns; ++c)
+			if (r % 5 >= 3 && c % 5 >= 3)
+				floor.at(r, c) = '#';
+	return move(floor.text);
+}
+
+string winding_corridor(size_t rows, size_t columns)
+{
+	Drawing floor(rows, columns);
+	for (size_t r = 1; r + 1 < rows; r += 2)
+	{
+		for (size_t c = 1; c + 1 < columns; ++c)
+			floor.at(r, c) = ' ';
+		if (r + 3 < rows)
+			floor.at(r + 1, r % 4 == 1 ? columns - 2 : 1) = ' ';
+	}
+	return move(floor.text);
+}
+
+string defect_room(size_t rows, size_t columns, bool sameColor, FloorRandom &random)
+{
+	Drawing floor(rows, columns);
+	floor.open_inside();
+	size_t r1 = 1 + random.below(rows - 2), c1 = 1 + random.below(columns - 2);
+	size_t r2, c2;
+	do
+	{
+		r2 = 1 + random.below(rows - 2);
+		c2 = 1 + random.below(columns - 2);
+	} while ((r1 == r2 && c1 == c2) || ((r1 + c1 + r2 + c2) % 2 == 0) != sameColor);
+	floor.at(r1, c1) = '#';
+	floor.at(r2, c2) = '#';
+	return move(floor.text);
+}
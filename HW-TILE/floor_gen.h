@@ -0,0 +1,89 @@
+#ifndef FLOOR_GEN_H
+#define FLOOR_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Seeded source of random numbers for the generators below.
+//
+// The sequence depends only on the seed, not on the platform or the
+// standard library, so a seed names the same floors on every machine.
+// Standard distributions aren't used for that reason.
+class FloorRandom
+{
+public:
+	explicit FloorRandom(uint64_t seed);
+
+	// Returns the next 64 random bits.
+	uint64_t next();
+
+	// Returns a number from 0 up to, but not including, n, which must not
+	// be 0.
+	uint64_t below(uint64_t n);
+
+	// Returns true with probability p.
+	bool chance(double p);
+
+private:
+	uint64_t state;
+};
+
+// Floor generators, for tests, benchmarks and tuning.
+//
+// Every generator returns a floor of exactly rows lines of columns cells,
+// each line ending in '\n', with a wall all around, so rows and columns
+// count the walls. They need rows and columns of at least 3 unless they
+// say otherwise.
+
+// An open room inside a wall.
+string open_room(size_t rows, size_t columns);
+
+// An open room with each of its cells made a wall with probability
+// walls.
+string random_maze(size_t rows, size_t columns, double walls, FloorRandom &random);
+
+// The mazes of main.cpp: walls with a hole the size of a domino in every
+// inner row. Unless tileable, one of those rows is then opened one more
+// cell at either end, so that no tiling exists. Needs rows of at least 4
+// and columns of at least 4.
+string domino_maze(size_t rows, size_t columns, bool tileable, FloorRandom &random);
+
+// A floor that has a tiling: the room is covered by a random domino
+// tiling, and then each domino is made a wall with probability holes.
+// If the room has an odd number of cells, its last column stays a wall.
+string tiled_floor(size_t rows, size_t columns, double holes, FloorRandom &random);
+
+// A floor that just misses having a tiling: a tiled_floor with two open
+// cells of the same color made walls, which leaves the same number of
+// cells but not of each color. A floor with too few cells for that gets
+// a single cell walled or opened instead.
+string near_miss(size_t rows, size_t columns, double holes, FloorRandom &random);
+
+// An open room with holes: each cell starts a rectangular hole of 1 to 3
+// cells a side with probability holes.
+string holey_floor(size_t rows, size_t columns, double holes, FloorRandom &random);
+
+// A strip length rows long and width open cells wide, with each of its
+// cells made a wall with probability walls.
+string long_strip(size_t length, size_t width, double walls, FloorRandom &random);
+
+// The Aztec diamond of the given order, in a floor of 2 * order + 2 rows
+// and columns. It always has a tiling.
+string aztec_diamond(size_t order);
+
+// An open room with 2 by 2 pillars standing on a grid 5 cells apart.
+string pillar_room(size_t rows, size_t columns);
+
+// A corridor one cell wide winding through the floor, along every other
+// row and down at alternate ends.
+string winding_corridor(size_t rows, size_t columns);
+
+// An open room with two cells made walls, of the same color if
+// sameColor and of different colors if not. Needs at least 2 open cells
+// of each color, rows and columns of at least 4.
+string defect_room(size_t rows, size_t columns, bool sameColor, FloorRandom &random);
+
+#endif
@@ -0,0 +1,31 @@
+#include "grid_kernels.h"
+
+using namespace std;
+
+bool solve_fixed_width(string_view floor, vector<uint64_t> &rows, string &colored, Reduction &result)
+{
+	switch (floor.find('\n'))
+	{
+	case 8:
+		return solve_width<8>(floor, rows, colored, result);
+	case 16:
+		return solve_width<16>(floor, rows, colored, result);
+	case 32:
+		return solve_width<32>(floor, rows, colored, result);
+	case 64:
+		return solve_width<64>(floor, rows, colored, result);
+	default:
+		return false;
+	}
+}
+
+Reduction solve_row_words(const vector<uint64_t> &rows, int columns, string &colored)
+{
+	if (columns <= 8)
+		return solve_rows<8>(rows, colored);
+	if (columns <= 16)
+		return solve_rows<16>(rows, colored);
+	if (columns <= 32)
+		return solve_rows<32>(rows, colored);
+	return solve_rows<64>(rows, colored);
+}
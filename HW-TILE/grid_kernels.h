@@ -0,0 +1,217 @@
+#ifndef GRID_KERNELS_H
+#define GRID_KERNELS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bits.h"
+#include "tiling.h"
+
+using namespace std;
+
+// Kernels over floors whose lines all have the same length W, which is a
+// compile-time constant. Each line of W cells becomes one word with bit
+// c set when column c is open, so row strides and masks are constants
+// and the loops carry no division or bounds checks.
+//
+// solve_fixed_width picks the instantiation that matches a floor; any
+// other floor is left to the generic string path.
+
+// Bits of a row word that hold cells.
+template <int W>
+constexpr uint64_t row_mask()
+{
+	return W == 64 ? ~uint64_t(0) : (uint64_t(1) << W) - 1;
+}
+
+// Reads a floor made of lines of exactly W cells, each ending in a
+// newline. Returns false if the floor has any other layout.
+template <int W>
+bool parse_rows(string_view floor, vector<uint64_t> &rows)
+{
+	const size_t Stride = W + 1;
+	if (floor.length() % Stride != 0)
+		return false;
+
+	size_t numRows = floor.length() / Stride;
+	rows.resize(numRows);
+	const char* text = floor.data();
+	for (size_t r = 0; r < numRows; ++r, text += Stride)
+	{
+		if (text[W] != '\n')
+			return false;
+		uint64_t bits = 0;
+		bool other = false;
+		for (int c = 0; c < W; ++c)
+		{
+			bits |= uint64_t(text[c] == ' ') << c;
+			other |= text[c] != ' ' && text[c] != '#';
+		}
+		if (other)
+			return false;
+		rows[r] = bits;
+	}
+	return true;
+}
+
+// Returns whether the floor has as many black cells as red cells.
+template <int W>
+bool balanced_colors(const vector<uint64_t> &rows)
+{
+	const uint64_t Even = 0x5555555555555555ULL & row_mask<W>();
+	const uint64_t Odd = 0xAAAAAAAAAAAAAAAAULL & row_mask<W>();
+	long long difference = 0;
+	for (size_t r = 0; r < rows.size(); ++r)
+	{
+		uint64_t black = r % 2 == 0 ? Even : Odd;
+		difference += popcount64(rows[r] & black) - popcount64(rows[r] & ~black);
+	}
+	return difference == 0;
+}
+
+// Returns whether some open cell has no open neighbor.
+template <int W>
+bool has_isolated_cell(const vector<uint64_t> &rows)
+{
+	for (size_t r = 0; r < rows.size(); ++r)
+	{
+		uint64_t row = rows[r];
+		uint64_t around = ((row << 1) | (row >> 1)) & row_mask<W>();
+		if (r > 0)
+			around |= rows[r - 1];
+		if (r + 1 < rows.size())
+			around |= rows[r + 1];
+		if (row & ~around)
+			return true;
+	}
+	return false;
+}
+
+// Writes the floor as color_floor would, for match_floor.
+template <int W>
+void color_rows(const vector<uint64_t> &rows, string &colored)
+{
+	const size_t Stride = W + 1;
+	colored.assign(rows.size() * Stride, '#');
+	char* out = &colored[0];
+	for (size_t r = 0; r < rows.size(); ++r, out += Stride)
+	{
+		for (int c = 0; c < W; ++c)
+			if ((rows[r] >> c) & 1)
+				out[c] = (r + c) % 2 == 0 ? 'b' : 'r';
+		out[W] = '\n';
+	}
+}
+
+// Returns whether the floor has a tiling by broken-profile dynamic
+// programming, one cell at a time. A profile is a W-bit mask: bits
+// below the current column mark cells of the next row already covered
+// by vertical dominoes, and the others mark covered cells of the
+// current row. The set of reachable profiles is kept as a bitset.
+template <int W>
+bool profile_dp(const vector<uint64_t> &rows)
+{
+	const size_t States = size_t(1) << W;
+	const size_t Words = (States + 63) / 64;
+	uint64_t reach[2][Words];
+	for (size_t w = 0; w < Words; ++w)
+		reach[0][w] = 0;
+	reach[0][0] = 1;
+	int cur = 0;
+
+	for (size_t r = 0; r < rows.size(); ++r)
+	{
+		uint64_t row = rows[r];
+		uint64_t below = r + 1 < rows.size() ? rows[r + 1] : 0;
+
+		for (int c = 0; c < W; ++c)
+		{
+			const uint64_t Bit = uint64_t(1) << c;
+			bool open = row & Bit;
+			bool downOpen = below & Bit;
+			bool rightOpen = c + 1 < W && (row >> (c + 1)) & 1;
+			uint64_t* from = reach[cur];
+			uint64_t* to = reach[1 - cur];
+			bool any = false;
+			for (size_t w = 0; w < Words; ++w)
+				to[w] = 0;
+
+			for (size_t w = 0; w < Words; ++w)
+			{
+				uint64_t bits = from[w];
+				while (bits != 0)
+				{
+					uint64_t s = w * 64 + lowest_bit(bits);
+					bits &= bits - 1;
+					bool covered = s & Bit;
+					uint64_t t;
+
+					if (!open || covered)
+					{
+						// A wall can't be covered; a covered cell is done.
+						if (!open && covered)
+							continue;
+						t = s & ~Bit;
+						to[t >> 6] |= uint64_t(1) << (t & 63);
+						any = true;
+						continue;
+					}
+					if (downOpen)
+					{
+						t = s | Bit;
+						to[t >> 6] |= uint64_t(1) << (t & 63);
+						any = true;
+					}
+					if (rightOpen && !((s >> (c + 1)) & 1))
+					{
+						t = s | (Bit << 1);
+						to[t >> 6] |= uint64_t(1) << (t & 63);
+						any = true;
+					}
+				}
+			}
+
+			if (!any)
+				return false;
+			cur = 1 - cur;
+		}
+	}
+	return reach[cur][0] & 1;
+}
+
+// Runs the kernels for width W on a floor already read into row words.
+// When the result is Undecided, colored holds the floor ready for
+// reduce_floor and match_floor.
+template <int W>
+Reduction solve_rows(const vector<uint64_t> &rows, string &colored)
+{
+	if (!balanced_colors<W>(rows) || has_isolated_cell<W>(rows))
+		return Reduction::NoTiling;
+	if constexpr (W <= 16)
+		return profile_dp<W>(rows) ? Reduction::Tiled : Reduction::NoTiling;
+	color_rows<W>(rows, colored);
+	return Reduction::Undecided;
+}
+
+// Runs the kernels for width W. Returns false if the floor isn't made of
+// lines of exactly W cells. Otherwise sets result as solve_rows does.
+template <int W>
+bool solve_width(string_view floor, vector<uint64_t> &rows, string &colored, Reduction &result)
+{
+	if (!parse_rows<W>(floor, rows))
+		return false;
+	result = solve_rows<W>(rows, colored);
+	return true;
+}
+
+// Dispatches to the instantiation matching the floor's width, if any.
+// rows and colored are scratch buffers that callers may reuse.
+bool solve_fixed_width(string_view floor, vector<uint64_t> &rows, string &colored, Reduction &result);
+
+// Runs the narrowest kernel that fits a floor given as one word per row,
+// bit c being column c, with at most 64 columns. Columns past the given
+// count must be clear; they act as walls.
+Reduction solve_row_words(const vector<uint64_t> &rows, int columns, string &colored);
+
+#endif
@@ -1,9 +1,35 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
 #include <vector>
+#include <algorithm>
+#include <thread>
 #include<time.h>
 #include "tiling.h"
+#include "batch.h"
+#include "floor.h"
+#include "pipeline.h"
+#include "floor_batch.h"
+#include "small_floor.h"
+#include "grid_kernels.h"
+#include "tiny_lanes.h"
+#include "shape_table.h"
+#include "persistent_cache.h"
+#include "result_cache.h"
+#include "tiling_server.h"
+#include "shared_ring.h"
+#include "async_solve.h"
+#include "solutions.h"
+#include "mapped_file.h"
+#include "packed_floor.h"
+#include "rle_floor.h"
+#include "compressed_input.h"
+#include "stream_tiling.h"
+#include "out_of_core.h"
+#include "floor_gen.h"
+#include <sstream>
+#include <fstream>
 
 using namespace std;
 
@@ -20,7 +46,7 @@ int main()
 {
 	clock_t t_clock = clock();
 	// Setup
-        srand(2018 + 'f');
+        FloorRandom random(2018 + 'f');
 	string floor;
 	
 	floor = "";
@@ -278,43 +304,713 @@ int main()
 	test(!has_tiling(floor));
 
         // Try some random mazes
+        vector<string> mazes;
+        vector<bool> expected;
         for (int trial = 0; trial < 500; ++trial)
         {
-                bool ok = static_cast<bool>(rand() % 2);
-                int height = 6 + (rand() % 10); 
-                int width = 7 + (rand() % 10); 
-                floor = "";
-                for (int i = 0; i < height; ++i) 
+                bool ok = random.below(2) == 1;
+                int height = 6 + static_cast<int>(random.below(10));
+                int width = 7 + static_cast<int>(random.below(10));
+                floor = domino_maze(height, width, ok, random);
+                mazes.push_back(floor);
+                expected.push_back(ok);
+                test(has_tiling(floor) == ok);
+        }
+
+        // Generated floors are the same for a seed and have the answer they promise
+        for (uint64_t seed = 0; seed < 50; ++seed)
+        {
+                FloorRandom first(seed), second(seed);
+                size_t rows = 3 + first.below(8), columns = 3 + first.below(8);
+                second.below(8), second.below(8);
+                string tiled = tiled_floor(rows, columns, 0.2, first);
+                test(tiled == tiled_floor(rows, columns, 0.2, second));
+                test(tiled.size() == rows * (columns + 1) && has_tiling(tiled));
+                test(!has_tiling(near_miss(rows, columns, 0.2, first)));
+                test(has_tiling(defect_room(4 + rows, 4, false, first)));
+                test(!has_tiling(defect_room(4 + rows, 4, true, first)));
+        }
+        test(FloorRandom(7).next() == FloorRandom(7).next() && FloorRandom(7).next() != FloorRandom(8).next());
+        test(has_tiling(aztec_diamond(6)) && has_tiling(open_room(6, 7)) && !has_tiling(open_room(5, 5)));
+        string strip = long_strip(1000, 3, 0, random);
+        test(strip.size() == 1002 * 6 && count(strip.begin(), strip.end(), ' ') == 3000);
+
+        // Stats say where a solve went, and add up over solves
+        SolveStats stats;
+        test(has_tiling(open_room(14, 14), stats));
+        test(stats.augmentations > 0 && stats.verticesVisited > 0 && stats.edgesScanned > stats.verticesVisited);
+        test(stats.buildSeconds > 0 && stats.matchSeconds > 0 && stats.peakBytes > 0);
+        SolveStats before = stats;
+        test(has_tiling(open_room(14, 14), stats) && stats.augmentations > before.augmentations);
+        test(!has_tiling(near_miss(14, 14, 0, random), stats));
+        test(has_tiling("##\n  \n##\n", stats));
+        test(stats.augmentations >= before.augmentations && stats.parseSeconds > before.parseSeconds);
+        test(stats.peakBytes >= before.peakBytes);
+
+        // A cancelled flow stops before its next augmenting path
+        {
+                string colored;
+                color_floor(open_room(14, 14), colored);
+                atomic<bool> stop(true);
+                SolveStats stopped;
+                test(!match_floor(colored, &stop, &stopped) && stopped.augmentations == 0);
+                stop = false;
+                test(match_floor(colored, &stop));
+
+                // Only a solve that gave up reports being cancelled
+                TilingContext context;
+                test(context.solve(open_room(14, 14), &stop) && !context.cancelled());
+                stop = true;
+                test(!context.solve(open_room(14, 14), &stop) && context.cancelled());
+                test(context.solve("##\n  \n##\n", &stop) && !context.cancelled());
+        }
+
+        // The small-floor engine agrees whenever a maze fits in it
+        int smallMazes = 0;
+        for (size_t i = 0; i < mazes.size(); ++i)
+        {
+                SmallFloor small;
+                if (!load_small_floor(mazes[i], small))
+                        continue;
+                test(small.rows * small.width <= SmallFloorCells);
+                test(small_has_tiling(small) == expected[i]);
+                ++smallMazes;
+        }
+        test(smallMazes > 0);
+
+        // Tilings found cover every open cell with whole dominoes
+        for (size_t i = 0; i < mazes.size(); ++i)
+        {
+                string tiled, grid;
+                test(find_tiling(mazes[i], tiled) == expected[i]);
+                if (!expected[i])
+                        continue;
+                color_floor(mazes[i], grid);
+                size_t stride = grid.find('\n') + 1;
+                test(tiled.length() == grid.length());
+                for (size_t k = 0; k < grid.length(); ++k)
+                {
+                        if (grid[k] != 'b' && grid[k] != 'r')
+                                test(tiled[k] == grid[k]);
+                        else if (tiled[k] == '<')
+                                test(tiled[k + 1] == '>');
+                        else if (tiled[k] == '^')
+                                test(tiled[k + stride] == 'v');
+                        else
+                                test(tiled[k] == '>' || tiled[k] == 'v');
+                }
+        }
+
+        // Counts of well-known boards
+        string counted;
+        test(count_tilings("####\n#  #\n#  #\n####\n", counted) && counted == "2");
+        test(count_tilings("#####\n#   #\n#   #\n#####\n", counted) && counted == "3");
+        test(count_tilings("#####\n#   #\n#   #\n#   #\n#####\n", counted) && counted == "0");
+        string board = string(10, '#') + "\n";
+        for (int i = 0; i < 8; ++i)
+                board += "#        #\n";
+        board += string(10, '#') + "\n";
+        test(count_tilings(board, counted) && counted == "12988816");
+        board = "#" + string(90, ' ') + "#\n";
+        test(count_tilings(board + board, counted) && counted == "4660046610375530309");
+        board = "#" + string(100, ' ') + "#\n";
+        test(count_tilings(board + board, counted) && counted == "573147844013817084101");
+        string wide;
+        for (int i = 0; i < 20; ++i)
+                wide += "#" + string(20, ' ') + "#\n";
+        test(!count_tilings(wide, counted));
+
+        // Rotated and mirrored rooms share one cache entry
+        floor = "";
+        floor += "##############\n";
+        floor += "#   ##########\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#            #\n";
+        floor += "#           ##\n";
+        floor += "##############\n";
+        string turned, mirrored;
+        for (int j = 0; j < 14; ++j)
+        {
+                for (int i = 13; i >= 0; --i)
+                        turned += floor[i * 15 + j];
+                turned += '\n';
+        }
+        for (int i = 0; i < 14; ++i)
+        {
+                for (int j = 13; j >= 0; --j)
+                        mirrored += floor[i * 15 + j];
+                mirrored += '\n';
+        }
+        test(canonical_form(floor) == canonical_form(turned));
+        test(canonical_form(floor) == canonical_form(mirrored));
+        test(canonical_form(floor) != canonical_form(mazes[0]));
+
+        ResultCache cache(64, 4);
+        test(cache.has_tiling(floor) == has_tiling(floor));
+        test(cache.has_tiling(turned) == has_tiling(floor));
+        test(cache.has_tiling(mirrored) == has_tiling(floor));
+        test(cache.stats().misses == 1 && cache.stats().hits == 2);
+        test(cache.size() == 1);
+
+        // Two copies of the room in one floor: the second is a hit
+        test(cache.has_tiling(floor + floor) == has_tiling(floor));
+        test(cache.stats().misses == 1 && cache.stats().hits == 4);
+
+        // Threads asking at once solve the room only once
+        cache.clear();
+        vector<thread> askers;
+        for (int i = 0; i < 8; ++i)
+                askers.emplace_back([&, i] { test(cache.has_tiling(i % 2 ? turned : mirrored) == has_tiling(floor)); });
+        for (thread &t : askers)
+                t.join();
+        test(cache.stats().misses == 2);
+
+        // Answers written to a table file are found by a later process
+        const char* tablePath = "hw_tile_results.tmp";
+        remove(tablePath);
+
+#ifndef _WIN32
+        // The server answers pipelined requests in any order
+        {
+                ServerOptions serving;
+                serving.socketPath = "hw_tile.sock";
+                serving.threads = 2;
+                TilingServer server(serving);
+                thread serverThread([&server] { server.run(); });
+
+                TilingClient client(serving.socketPath);
+                vector<uint32_t> ids;
+                for (const string &maze : mazes)
+                        ids.push_back(client.send(Op::HasTiling, maze));
+                uint32_t id;
+                Status status;
+                string payload;
+                vector<int> served(mazes.size(), -1);
+                for (size_t i = 0; i < mazes.size(); ++i)
+                {
+                        test(client.receive(id, status, payload));
+                        size_t k = find(ids.begin(), ids.end(), id) - ids.begin();
+                        test(k < mazes.size() && served[k] == -1);
+                        served[k] = status == Status::Tiled;
+                }
+                test(equal(served.begin(), served.end(), expected.begin()));
+                test(client.has_tiling(floor) == has_tiling(floor));
+                client.send(static_cast<Op>(99));
+                test(client.receive(id, status, payload) && status == Status::BadRequest);
+                test(client.stats().find("requests " + to_string(mazes.size() + 1) + "\n") == 0);
+                string served_text, local_text;
+                for (size_t i = 0; i < mazes.size(); ++i)
                 {
-                        string row;
-                        for (int j = 0; j < width; ++j)
-                                row += "#";
-                        if (i != 0 && i != height-1)
+                        test(client.tiling(mazes[i], served_text) == find_tiling(mazes[i], local_text));
+                        test(served_text == (expected[i] ? local_text : string()));
+                }
+                test(client.count("#####\n#   #\n#   #\n#####\n", served_text) && served_text == "3");
+                test(!client.count(wide, served_text) && served_text.empty());
+
+                // A client that stops sending still gets every answer
+                TilingClient leaving(serving.socketPath);
+                for (const string &maze : mazes)
+                        leaving.send(Op::HasTiling, maze);
+                leaving.send(Op::Stats);
+                leaving.finish_sending();
+                size_t answers = 0;
+                while (leaving.receive(id, status, payload))
+                        answers++;
+                test(answers == mazes.size() + 1);
+
+                server.stop();
+                serverThread.join();
+        }
+#endif
+
+#ifdef __linux__
+        // Floors written straight into a shared ring are solved in place
+        {
+                size_t longest = floor.size();
+                for (const string &maze : mazes)
+                        longest = max(longest, maze.size());
+                SharedRingServer ringServer("hw_tile.ring", 4, longest);
+                ThreadPool ringPool(2);
+                thread ringThread([&] { ringServer.serve(ringPool); });
+
+                SharedRingClient ring("hw_tile.ring");
+                unsigned slot = ring.acquire();
+                test(ring.slot_capacity() >= floor.size());
+                copy(floor.begin(), floor.end(), ring.slot_data(slot));
+                ring.submit(slot, floor.size());
+                test(ring.wait(slot) == has_tiling(floor));
+
+                // More clients than slots
+                vector<thread> ringClients;
+                for (int c = 0; c < 6; ++c)
+                        ringClients.emplace_back([&, c]
                         {
-                                int ko = 1 + (rand() % (width-3));
-                                row[ko] = ' ';
-                                row[ko+1] = ' ';                        
-                        }
-                        floor += row + '\n';
+                                SharedRingClient own("hw_tile.ring");
+                                for (size_t i = c; i < mazes.size(); i += 6)
+                                        test(own.has_tiling(mazes[i]) == expected[i]);
+                        });
+                for (thread &t : ringClients)
+                        t.join();
+
+                ringServer.stop();
+                ringThread.join();
+        }
+#endif
+        {
+                PersistentCache store(tablePath, 100);
+                test(store.capacity() == 128 && store.size() == 0);
+                ResultCache first;
+                first.persist_to(&store);
+                test(first.has_tiling(floor) == has_tiling(floor));
+                test(store.size() == 1 && first.stats().misses == 1);
+                test(!store.insert(canonical_form(mirrored), !has_tiling(floor)));
+        }
+        {
+                PersistentCache store(tablePath);
+                test(store.capacity() == 128 && store.size() == 1);
+                bool answer;
+                test(store.find(canonical_form(turned), answer) && answer == has_tiling(floor));
+                test(!store.find(canonical_form(mazes[0]), answer));
+                ResultCache restarted;
+                restarted.persist_to(&store);
+                test(restarted.has_tiling(turned) == has_tiling(floor));
+                test(restarted.stats().misses == 0 && restarted.stats().hits == 1);
+        }
+        remove(tablePath);
+
+        // A table whose maker died before writing its header is made again
+        {
+                ofstream(tablePath, ios::binary) << string(64, '\0');
+                PersistentCache store(tablePath, 100);
+                test(store.is_open() && store.capacity() == 128 && store.size() == 0);
+                test(store.insert(canonical_form(floor), has_tiling(floor)));
+        }
+        {
+                ofstream(tablePath, ios::binary) << "HW";
+                PersistentCache store(tablePath, 100);
+                test(store.is_open() && store.capacity() == 128 && store.size() == 0);
+        }
+
+        // Any other file leaves the cache closed instead
+        {
+                ofstream(tablePath, ios::binary) << "not a table of results";
+                PersistentCache store(tablePath, 100);
+                bool answer;
+                test(!store.is_open() && store.capacity() == 0 && store.size() == 0);
+                test(!store.insert(canonical_form(floor), true) && !store.find(canonical_form(floor), answer));
+        }
+        remove(tablePath);
+
+        // The 4x4 shape table
+        test(window_has_tiling(0x0000) && window_has_tiling(0xFFFF));
+        test(window_has_tiling(0x0033) && !window_has_tiling(0x0007));
+        test(!window_has_tiling(0x8421) && window_has_tiling(0x0660));
+        test(!window_has_tiling(0x9009) && window_has_tiling(0x1111));
+
+        // Tiny floors decided several at a time, one per lane
+        const char* tinyFloors[] = {
+                "######\n#    #\n######\n",
+                "#######\n#     #\n#######\n",
+                "####\n#  #\n# ##\n####\n",
+                "#####\n# # #\n# # #\n#####\n",
+                "######\n###  #\n##  ##\n#  ###\n######\n",
+                "######\n###  #\n#    #\n#  # #\n######\n",
+                "#######\n##   ##\n## # ##\n##   ##\n#######\n",
+                "#######\n##   ##\n###  ##\n##   ##\n#######\n",
+                "##########\n#        #\n#        #\n#        #\n##########\n",
+        };
+        const bool tinyExpected[] = { true, false, false, true, true, false, true, false, true };
+        uint64_t tinyCells[9];
+        bool tinyAnswers[9];
+        for (int i = 0; i < 9; ++i)
+                test(load_tiny_floor(tinyFloors[i], tinyCells[i]));
+        tiny_has_tiling(tinyCells, 9, tinyAnswers);
+        for (int i = 0; i < 9; ++i)
+                test(tinyAnswers[i] == tinyExpected[i]);
+        test(!load_tiny_floor("###########\n#         #\n###########\n", tinyCells[0]));
+
+        // Floors of the widths with their own kernels
+        for (int width : { 8, 16, 32 })
+        {
+                string wall(width, '#');
+                string open = "#" + string(width - 2, ' ') + "#";
+                floor = wall + "\n";
+                for (int i = 0; i < 7; ++i)
+                        floor += open + "\n";
+                floor += wall + "\n";
+
+                vector<uint64_t> rows;
+                string colored;
+                Reduction reduced;
+                test(solve_fixed_width(floor, rows, colored, reduced));
+                test(reduced != Reduction::NoTiling);
+                test(rows.size() == 9 && rows[0] == 0);
+                test(rows[1] == (~uint64_t(0) >> (64 - (width - 2))) << 1);
+                test(has_tiling(floor));
+
+                // A single cell opened in the bottom wall is left over
+                floor[8 * (width + 1) + 1] = ' ';
+                test(!has_tiling(floor));
+                floor[8 * (width + 1) + 2] = ' ';
+                test(has_tiling(floor));
+        }
+
+        // The batch solver must agree with has_tiling
+        vector<string_view> views(mazes.begin(), mazes.end());
+        test(has_tiling_batch(views) == expected);
+
+        ThreadPool pool(4);
+        test(has_tiling_batch(views, pool) == expected);
+        test(has_tiling_batch(vector<string_view>(), pool).empty());
+
+        // Results reported in completion order cover every floor once
+        vector<int> reported(views.size(), 0);
+        has_tiling_batch(views, pool, [&](size_t i, bool answer)
+        {
+                test(answer == expected[i]);
+                ++reported[i];
+        });
+        test(count(reported.begin(), reported.end(), 1) == static_cast<int>(views.size()));
+
+        // A large floor made of many rooms is split into its components
+        floor = "";
+        for (int i = 0; i < 10000; ++i)
+                floor += "#######\n##   ##\n## # ##\n##   ##\n";
+        floor += "#######\n";
+        test(has_tiling_batch({ floor }, pool)[0]);
+        floor[floor.length() / 2 / 32 * 32 + 9] = ' ';
+        test(!has_tiling_batch({ floor }, pool)[0]);
+
+        // A FloorBatch holds the same floors in one buffer
+        FloorBatch batch;
+        for (const string &maze : mazes)
+                batch.add(maze);
+        test(batch.size() == mazes.size() && !batch.has_dimensions());
+        test(batch[7] == mazes[7]);
+        test(has_tiling_batch(batch, pool) == expected);
+
+        // Floors read from a stream are split at blank lines
+        stringstream text;
+        for (size_t i = 0; i < mazes.size(); ++i)
+                text << mazes[i] << (i % 2 ? "\n" : "\r\n\n");
+        FloorBatch loaded;
+        test(read_floors(text, loaded) == mazes.size());
+        test(loaded.has_dimensions() && loaded[3] == mazes[3]);
+        test(loaded.rows(3) == static_cast<int>(count(mazes[3].begin(), mazes[3].end(), '\n')));
+        test(loaded.width(3) == static_cast<int>(mazes[3].find('\n')));
+        test(has_tiling_batch(loaded, pool) == expected);
+
+        // Floors found in place match the ones read into a batch
+        string allText = text.str();
+        vector<string_view> found;
+        test(split_floors(allText, found) == mazes.size());
+        for (size_t i = 0; i < mazes.size(); ++i)
+                test(found[i] == mazes[i]);
+
+        // A mapped file is solved where it lies
+        {
+                const char* mappedPath = "hw_tile_floors.tmp";
+                ofstream(mappedPath, ios::binary) << allText;
+                MappedFile mapped;
+                test(mapped.open(mappedPath) && mapped.view() == allText);
+                found.clear();
+                split_floors(mapped.view(), found);
+                test(has_tiling_batch(found, pool) == expected);
+                ofstream(mappedPath, ios::binary) << mazes[1];
+                test(has_tiling_file(mappedPath) == expected[1]);
+                mapped.close();
+                remove(mappedPath);
+        }
+
+        // Packed floors solve straight from their row words
+        string packed;
+        for (size_t i = 0; i < mazes.size(); ++i)
+                pack_floor(mazes[i], packed, expected[i] ? PackedKnown | PackedTiled : PackedKnown);
+        size_t packedAt = 0;
+        PackedFloor record;
+        for (size_t i = 0; i < mazes.size(); ++i)
+        {
+                test(read_packed(packed, packedAt, record));
+                test(((record.flags & PackedTiled) != 0) == expected[i]);
+                test(has_tiling_packed(record) == expected[i]);
+                string unpacked;
+                unpack_floor(record, unpacked);
+                test(has_tiling(unpacked) == expected[i]);
+        }
+        test(!read_packed(packed, packedAt, record) && packedAt == packed.size());
+
+        // PBM images keep walls black and open cells white
+        string image;
+        write_pbm("####\n#  #\n# ##\n####\n", image);
+        write_pbm(mazes[3], image);
+        string pictured;
+        size_t imageAt = 0;
+        test(read_pbm(image, imageAt, pictured) && pictured == "####\n#  #\n# ##\n####\n");
+        test(read_pbm(image, imageAt, pictured) && has_tiling(pictured) == expected[3]);
+        imageAt = 0;
+        test(read_pbm("P1\n# plain\n3 2\n1 0 1\n0 0 1\n", imageAt, pictured) && pictured == "# #\n  #\n");
+
+        // Headers claiming more pixels than follow, or sizes past 32 bits, are rejected
+        for (const char* malformed : { "P1 4294967295 1\n1 1 1 1\n", "P1 4294967296 1\n1\n", "P4 4294967295 2\n\xff\xff",
+                "P1 3 99999999999999999999\n1 0 1\n" })
+        {
+                imageAt = 0;
+                test(!read_pbm(malformed, imageAt, pictured) && imageAt == 0);
+        }
+
+        // Run-length floors agree with the text they encode
+        string encoded;
+        for (size_t i = 0; i < mazes.size(); ++i)
+        {
+                RunFloor runs;
+                encode_runs(mazes[i], runs);
+                test(has_tiling_runs(runs) == expected[i]);
+                write_rle(runs, encoded);
+        }
+        size_t encodedAt = 0;
+        for (size_t i = 0; i < mazes.size(); ++i)
+        {
+                RunFloor runs;
+                string decoded, colored, recolored;
+                test(read_rle(encoded, encodedAt, runs));
+                decode_runs(runs, decoded);
+                color_floor(mazes[i], colored);
+                color_floor(decoded, recolored);
+                test(colored == recolored);
+        }
+
+        // Ten billion cells in a few lines: open rooms split by a wall,
+        // and a notched room that has to be drawn out
+        RunFloor huge;
+        size_t hugeAt = 0;
+        test(read_rle("rle 100000 100000\n1 49999 2 49997 1\n99998:1 49999 2 49997 1\n\n", hugeAt, huge));
+        test(huge.rows == 100000 && huge.runs.size() == 2 * 99999);
+        test(!has_tiling_runs(huge));
+        hugeAt = 0;
+        test(read_rle("rle 100000 100000\n1 49998 2 49998 1\n99998:1 49998 2 49998 1\n\n", hugeAt, huge));
+        test(has_tiling_runs(huge));
+        hugeAt = 0;
+        test(read_rle("rle 5 6\n\n1 2\n1 4\n1 4 \n\n", hugeAt, huge) && hugeAt == 23);
+        test(has_tiling_runs(huge));
+        huge.runs[1].end = 4;
+        test(!has_tiling_runs(huge));
+
+        // An empty wall run between open runs joins them
+        hugeAt = 0;
+        test(read_rle("rle 1 2\n0 1 0 1\n", hugeAt, huge) && huge.runs.size() == 1 && has_tiling_runs(huge));
+
+#ifdef HW_TILE_ZLIB
+        // Compressed floors come out one by one, in order
+        {
+                const char* archivePath = "hw_tile_floors.gz";
+                test(write_compressed(archivePath, views));
+                for (size_t window : { 0, 1 })
+                {
+                        CompressedFloorReader reader(archivePath, pool, window);
+                        string inflated;
+                        size_t i = 0;
+                        while (reader.next(inflated))
+                                test(i < mazes.size() && inflated == mazes[i++]);
+                        test(reader.ok() && i == mazes.size());
                 }
-                
-                if (ok)
+                vector<int> unpacked(mazes.size(), -1);
+                test(solve_compressed(archivePath, [&](size_t i, bool answer) { unpacked[i] = answer; }) == mazes.size());
+                test(equal(unpacked.begin(), unpacked.end(), expected.begin()));
+
+                // A block claiming more than 64 KiB is corrupt
                 {
-                        test(has_tiling(floor));
-                        continue;
+                        ifstream in(archivePath, ios::binary);
+                        string packed((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+                        in.close();
+                        size_t blockSize = (static_cast<unsigned char>(packed[16]) | static_cast<unsigned char>(packed[17]) << 8) + size_t(1);
+                        packed.replace(blockSize - 4, 4, "\xff\xff\xff\x7f");
+                        ofstream(archivePath, ios::binary) << packed;
+                        CompressedFloorReader reader(archivePath, pool);
+                        string inflated;
+                        while (reader.next(inflated))
+                                ;
+                        test(!reader.ok());
                 }
-                
-                int bad_row = 1 + (rand() % (height-3)); 
-                int start = bad_row * (width + 1) + 1; 
-                while (floor[start] == ' ')
-                        ++start;
-                floor[start] = ' ';
-                int end = bad_row * (width + 1) + width - 2;
-                while (floor[end] == ' ')
-                        --end;
-                floor[end] = ' ';
-                test(!has_tiling(floor)); 
+
+                // Files that aren't gzip are read as they are
+                ofstream(archivePath, ios::binary) << allText;
+                CompressedFloorReader plain(archivePath, pool);
+                string inflated;
+                for (size_t i = 0; i < mazes.size(); ++i)
+                        test(plain.next(inflated) && inflated == mazes[i]);
+                test(!plain.next(inflated) && plain.ok());
+                remove(archivePath);
         }
+#endif
+
+        // Floors streamed row by row, with rooms sealed or folded into the frontier
+        for (size_t window : { size_t(0), size_t(2), StreamWindow })
+        {
+                stringstream rows(allText);
+                for (size_t i = 0; i < mazes.size(); ++i)
+                        test(has_tiling(rows, window) == expected[i]);
+        }
+        {
+                stringstream conveyor;
+                for (int r = 0; r < 100000; ++r)
+                        conveyor << (r % 1000 == 999 ? "# #### #\n" : "#      #\n");
+                conveyor << "\n#   #\n";
+                test(has_tiling(conveyor));
+                test(!has_tiling(conveyor));
+        }
+
+        // Rooms of any width are folded, holes and all
+        {
+                auto band = [](int rows, int open) { string text; for (int r = 0; r < rows; ++r) text += "#" + string(open, ' ') + string(24 - open, '#') + "#\n"; return text; };
+                stringstream tall(band(70, 24) + band(2, 10));
+                test(has_tiling(tall));
+                for (size_t window : { size_t(0), size_t(1), size_t(3) })
+                {
+                        stringstream widening(band(10, 6) + band(8, 24) + band(2, 10));
+                        test(has_tiling(widening, window));
+                        stringstream odd(band(10, 6) + band(8, 24) + band(1, 10) + band(1, 9));
+                        test(!has_tiling(odd, window));
+                }
+                auto pillars = [&band](int rows, int blocked)
+                {
+                        string text;
+                        for (int r = 0; r < rows; ++r)
+                                text += r == blocked ? band(1, 23) : r % 4 == 1 ? "#" + string(10, ' ') + "##" + string(10, ' ') + "#\n" : band(1, 24);
+                        return text;
+                };
+                stringstream holes(pillars(3000, -1));
+                test(has_tiling(holes));
+                stringstream blocked(pillars(3000, 1500));
+                test(!has_tiling(blocked));
+        }
+
+        // Floors solved out of core, in strips of a few rows at a time
+        {
+                const char* packedPath = "hw_tile_floor.hwtb";
+                for (size_t i = 0; i < mazes.size(); ++i)
+                {
+                        string record;
+                        pack_floor(mazes[i], record);
+                        ofstream(packedPath, ios::binary) << record;
+                        for (size_t strip : { size_t(1), size_t(3), size_t(4096) })
+                        {
+                                OutOfCoreOptions options;
+                                options.stripRows = strip;
+                                test(has_tiling_out_of_core(packedPath, options) == expected[i]);
+                        }
+                }
+                string corridor, record;
+                for (int r = 0; r < 1000; ++r)
+                        corridor += r == 0 || r == 999 ? "#  #\n" : "# ##\n";
+                pack_floor(corridor, record);
+                ofstream(packedPath, ios::binary) << record;
+                OutOfCoreOptions options;
+                options.stripRows = 16;
+                test(has_tiling_out_of_core(packedPath, options));
+                corridor[0] = ' ';
+                record.clear();
+                pack_floor(corridor, record);
+                ofstream(packedPath, ios::binary) << record;
+                test(!has_tiling_out_of_core(packedPath, options));
+                remove(packedPath);
+        }
+
+        // Length-prefixed floors may hold blank lines of their own
+        stringstream sized;
+        sized << "5\n##\n\n#\n" << "\n" << mazes[2].size() << "\r\n" << mazes[2];
+        FloorBatch sizedFloors;
+        test(read_sized_floors(sized, sizedFloors) == 2);
+        test(sizedFloors[0] == "##\n\n#" && sizedFloors.rows(0) == 3 && sizedFloors.width(0) == 2);
+        test(sizedFloors[1] == mazes[2]);
+        found.clear();
+        test(split_sized_floors(sized.str(), found) == 2 && found[0] == sizedFloors[0] && found[1] == mazes[2]);
+
+        // Asynchronous solves finish without anyone waiting on a thread
+        vector<TilingFuture> futures;
+        atomic<int> continued(0);
+        for (const string &maze : mazes)
+        {
+                futures.push_back(has_tiling_async(maze, pool));
+                futures.back().then([&continued] { ++continued; });
+        }
+        for (size_t i = 0; i < mazes.size(); ++i)
+                test(futures[i].get() == expected[i] && futures[i].ready());
+        while (continued.load() < static_cast<int>(mazes.size()))
+                this_thread::yield();
+
+        // A solve cancelled before it starts finishes at once
+        {
+                ThreadPool single(1);
+                atomic<bool> busy(false), release(false);
+                single.submit([&busy, &release] { busy = true; while (!release.load()) this_thread::yield(); });
+                // The solves must queue behind the busy worker, not be taken first
+                while (!busy.load())
+                        this_thread::yield();
+                TilingFuture queued = has_tiling_async(mazes[0], single);
+                TilingFuture kept = has_tiling_async(mazes[1], single);
+                test(queued.state() == SolveState::Queued);
+                queued.cancel();
+                test(queued.state() == SolveState::Cancelled && !queued.get());
+
+                // The awaitable interface, driven by a stand-in coroutine handle
+                struct Resumer
+                {
+                        bool* resumed;
+                        void resume() { *resumed = true; }
+                };
+                bool resumed = false;
+                test(!kept.await_ready() && kept.await_suspend(Resumer{ &resumed }));
+                test(!queued.await_suspend(Resumer{ &resumed }) && !resumed);
+                release = true;
+                test(kept.await_resume() == expected[1]);
+                while (!resumed)
+                        this_thread::yield();
+        }
+
+        // A solve cancelled while matching frees its worker
+        {
+                ThreadPool single(1);
+                TilingFuture running = has_tiling_async(open_room(80, 80), single);
+                while (running.state() == SolveState::Queued)
+                        this_thread::yield();
+                this_thread::sleep_for(chrono::milliseconds(50));
+                running.cancel();
+                test(!running.get() && running.state() == SolveState::Cancelled);
+        }
+
+        // The staged pipeline agrees as well
+        PipelineOptions stages;
+        stages.reduceThreads = 2;
+        stages.solveThreads = 3;
+        stages.queueCapacity = 16;
+        size_t nextMaze = 0;
+        vector<int> answers(mazes.size(), -1);
+        run_pipeline([&](string &out)
+        {
+                if (nextMaze == mazes.size())
+                        return false;
+                out = mazes[nextMaze++];
+                return true;
+        }, [&](size_t i, bool answer) { answers[i] = answer; }, stages);
+        test(equal(answers.begin(), answers.end(), expected.begin()));
+
+        // The scan sees every room of the floor
+        FloorInfo info = scan_floor(floor);
+        test(info.rows == 40001 && info.width == 7);
+        test(info.components == 10000 && info.openCells == 80001);
+
+        // One huge floor among many small ones is started first
+        views.push_back(floor);
+        expected.push_back(false);
+        test(has_tiling_batch(views, pool) == expected);
 
 
 	cout << "Assignment complete." << endl;
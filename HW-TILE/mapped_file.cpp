@@ -0,0 +1,207 @@
+#include <iostream>
+#include <utility>
+#include "mapped_file.h"
+#include "tiling.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+	: data(nullptr), length(0), opened(false)
+#ifdef _WIN32
+	, file(INVALID_HANDLE_VALUE), mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+	: MappedFile()
+{
+	*this = move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile &&other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		swap(data, other.data);
+		swap(length, other.length);
+		swap(opened, other.opened);
+#ifdef _WIN32
+		swap(file, other.file);
+		swap(mapping, other.mapping);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::open(const string &path)
+{
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER size;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+	{
+		cerr << "MappedFile::open() could not open " << path << "." << endl;
+		close();
+		return false;
+	}
+	length = static_cast<size_t>(size.QuadPart);
+	if (length > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+		if (!data)
+		{
+			cerr << "MappedFile::open() could not map " << path << "." << endl;
+			close();
+			return false;
+		}
+	}
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (file < 0 || fstat(file, &status) != 0)
+	{
+		cerr << "MappedFile::open() could not open " << path << "." << endl;
+		if (file >= 0)
+			::close(file);
+		return false;
+	}
+	length = static_cast<size_t>(status.st_size);
+	if (length > 0)
+	{
+		void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped == MAP_FAILED)
+		{
+			cerr << "MappedFile::open() could not map " << path << "." << endl;
+			::close(file);
+			length = 0;
+			return false;
+		}
+		madvise(mapped, length, MADV_SEQUENTIAL);
+		data = static_cast<const char*>(mapped);
+	}
+	// The mapping keeps the file alive on its own.
+	::close(file);
+#endif
+
+	opened = true;
+	return true;
+}
+
+bool MappedFile::create(const string &path, size_t size)
+{
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(size);
+	if (file == INVALID_HANDLE_VALUE || !SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+	{
+		cerr << "MappedFile::create() could not create " << path << "." << endl;
+		close();
+		return false;
+	}
+	length = size;
+	if (length > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+		data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+		if (!data)
+		{
+			cerr << "MappedFile::create() could not map " << path << "." << endl;
+			close();
+			return false;
+		}
+	}
+#else
+	int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (file < 0 || ftruncate(file, static_cast<off_t>(size)) != 0)
+	{
+		cerr << "MappedFile::create() could not create " << path << "." << endl;
+		if (file >= 0)
+			::close(file);
+		return false;
+	}
+	length = size;
+	if (length > 0)
+	{
+		void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		if (mapped == MAP_FAILED)
+		{
+			cerr << "MappedFile::create() could not map " << path << "." << endl;
+			::close(file);
+			length = 0;
+			return false;
+		}
+		data = static_cast<const char*>(mapped);
+	}
+	::close(file);
+#endif
+
+	opened = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data)
+		munmap(const_cast<char*>(data), length);
+#endif
+	data = nullptr;
+	length = 0;
+	opened = false;
+}
+
+bool MappedFile::is_open() const
+{
+	return opened;
+}
+
+string_view MappedFile::view() const
+{
+	return string_view(data, length);
+}
+
+char* MappedFile::writable() const
+{
+	return const_cast<char*>(data);
+}
+
+bool has_tiling_file(const string &path)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+	return has_tiling(file.view());
+}
@@ -0,0 +1,63 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// A whole file mapped into memory, read-only unless it was made by
+// create.
+//
+// The solver reads floors through string_view, so a mapped file can be
+// solved where it lies: nothing is read into a string first, and the
+// pages are file cache that the system can drop again under pressure.
+// A file opened for reading is hinted for one sequential pass.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile &&other) noexcept;
+	MappedFile& operator=(MappedFile &&other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the file, replacing any earlier mapping. Prints an error and
+	// returns false if it can't.
+	bool open(const string &path);
+
+	// Creates the file, or empties an existing one, at the given length
+	// and maps it for reading and writing; writes go to the file. Prints
+	// an error and returns false if it can't.
+	bool create(const string &path, size_t length);
+
+	// Unmaps the file. Views of it become invalid.
+	void close();
+
+	bool is_open() const;
+
+	// Returns the contents of the file, valid until it is closed.
+	string_view view() const;
+
+	// Returns the contents for writing, for a file mapped by create.
+	char* writable() const;
+
+private:
+	const char *data;
+	size_t length;
+	bool opened;
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#endif
+};
+
+// Returns whether the floor held in the file has a tiling, solving it
+// straight from a mapping of the file. Prints an error and returns false
+// if the file can't be mapped.
+bool has_tiling_file(const string &path);
+
+#endif
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "bits.h"
+#include "mapped_file.h"
+#include "out_of_core.h"
+#include "packed_floor.h"
+#include "stream_tiling.h"
+
+using namespace std;
+
+// The open cells of the work file, as rows of words.
+struct WorkFloor
+{
+	uint64_t *words;
+	size_t rows;
+	size_t wordsPerRow;
+	uint32_t columns;
+
+	uint64_t* row(size_t r) const
+	{
+		return words + r * wordsPerRow;
+	}
+
+	bool open(size_t r, size_t c) const
+	{
+		return (row(r)[c / 64] >> (c % 64)) & 1;
+	}
+
+	void cover(size_t r, size_t c) const
+	{
+		row(r)[c / 64] &= ~(uint64_t(1) << (c % 64));
+	}
+};
+
+struct Cell
+{
+	size_t r;
+	size_t c;
+};
+
+// Appends the open neighbors of a cell to out.
+static void open_neighbors(const WorkFloor &floor, Cell cell, vector<Cell> &out)
+{
+	if (cell.r > 0 && floor.open(cell.r - 1, cell.c))
+		out.push_back(Cell{ cell.r - 1, cell.c });
+	if (cell.r + 1 < floor.rows && floor.open(cell.r + 1, cell.c))
+		out.push_back(Cell{ cell.r + 1, cell.c });
+	if (cell.c > 0 && floor.open(cell.r, cell.c - 1))
+		out.push_back(Cell{ cell.r, cell.c - 1 });
+	if (cell.c + 1 < floor.columns && floor.open(cell.r, cell.c + 1))
+		out.push_back(Cell{ cell.r, cell.c + 1 });
+}
+
+// Places every domino forced on the cells of rows begin up to end, which
+// may reach into the row on either side. Sets above or below if a domino
+// covered a cell of the strip's first or last row, or of the row before
+// or after the strip, since the cells of the strip next door that touch
+// it may then be forced. Returns false if some cell can no longer be
+// covered.
+static bool reduce_strip(const WorkFloor &floor, size_t begin, size_t end, bool &above, bool &below)
+{
+	// Find the cells with at most one open neighbor, a word at a time.
+	vector<Cell> pending;
+	vector<uint64_t> none(floor.wordsPerRow, 0);
+	size_t n = floor.wordsPerRow;
+	for (size_t r = begin; r < end; ++r)
+	{
+		const uint64_t *cur = floor.row(r);
+		const uint64_t *up = r > 0 ? floor.row(r - 1) : none.data();
+		const uint64_t *down = r + 1 < floor.rows ? floor.row(r + 1) : none.data();
+		for (size_t k = 0; k < n; ++k)
+		{
+			uint64_t w = cur[k];
+			if (!w)
+				continue;
+			uint64_t left = (w << 1) | (k > 0 ? cur[k - 1] >> 63 : 0);
+			uint64_t right = (w >> 1) | (k + 1 < n ? cur[k + 1] << 63 : 0);
+			uint64_t a = up[k], b = down[k];
+			uint64_t two = (a & b) | ((a | b) & (left | right)) | (left & right);
+			for (uint64_t single = w & ~two; single; single &= single - 1)
+				pending.push_back(Cell{ r, k * 64 + lowest_bit(single) });
+		}
+	}
+
+	vector<Cell> around;
+	while (!pending.empty())
+	{
+		Cell cell = pending.back();
+		pending.pop_back();
+		if (!floor.open(cell.r, cell.c))
+			continue;
+		around.clear();
+		open_neighbors(floor, cell, around);
+		if (around.empty())
+			return false;
+		if (around.size() > 1)
+			continue;
+
+		Cell mate = around[0];
+		floor.cover(cell.r, cell.c);
+		floor.cover(mate.r, mate.c);
+		above |= cell.r == begin || mate.r <= begin;
+		below |= cell.r + 1 == end || mate.r + 1 >= end;
+
+		// Neighbors of the pair may now be forced in turn.
+		around.clear();
+		open_neighbors(floor, cell, around);
+		open_neighbors(floor, mate, around);
+		for (Cell next : around)
+			if (next.r >= begin && next.r < end)
+				pending.push_back(next);
+	}
+	return true;
+}
+
+bool has_tiling_out_of_core(const string &path, const OutOfCoreOptions &options)
+{
+	MappedFile input;
+	if (!input.open(path))
+		return false;
+	PackedFloor packed;
+	size_t offset = 0;
+	if (!read_packed(input.view(), offset, packed))
+		return false;
+
+	string workPath = options.workPath.empty() ? path + ".work" : options.workPath;
+	size_t bytes = size_t(packed.rows) * packed.wordsPerRow * 8;
+	MappedFile work;
+	if (!work.create(workPath, bytes))
+		return false;
+	memcpy(work.writable(), packed.words, bytes);
+	input.close();
+
+	WorkFloor floor;
+	floor.words = reinterpret_cast<uint64_t*>(work.writable());
+	floor.rows = packed.rows;
+	floor.wordsPerRow = packed.wordsPerRow;
+	floor.columns = packed.columns;
+
+	size_t stripRows = max<size_t>(options.stripRows, 1);
+	size_t strips = (floor.rows + stripRows - 1) / stripRows;
+	vector<bool> dirty(strips, true);
+	bool tiled = true;
+	bool changed = true;
+	for (int pass = 0; tiled && changed; ++pass)
+	{
+		changed = false;
+		for (size_t i = 0; i < strips && tiled; ++i)
+		{
+			size_t s = pass % 2 == 0 ? i : strips - 1 - i;
+			if (!dirty[s])
+				continue;
+			dirty[s] = false;
+			bool above = false, below = false;
+			tiled = reduce_strip(floor, s * stripRows, min(floor.rows, (s + 1) * stripRows), above, below);
+			if (above && s > 0)
+				dirty[s - 1] = changed = true;
+			if (below && s + 1 < strips)
+				dirty[s + 1] = changed = true;
+		}
+	}
+
+	if (tiled)
+	{
+		StreamTiling rest;
+		for (size_t r = 0; r < floor.rows && tiled; ++r)
+			tiled = rest.add_row(floor.row(r), floor.columns);
+		tiled = rest.finish();
+	}
+
+	work.close();
+	remove(workPath.c_str());
+	return tiled;
+}
@@ -0,0 +1,36 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+struct OutOfCoreOptions
+{
+	// Rows worked on at a time. A strip, with the row on either side of
+	// it, should fit in memory with plenty to spare.
+	size_t stripRows = 4096;
+	// Where the working copy of the floor goes; empty means the input's
+	// path with ".work" appended. It is removed once the solve is over.
+	string workPath;
+};
+
+// Returns whether the floor held in a packed file (the first record of a
+// .hwtb file; see packed_floor.h) has a tiling, for floors that don't fit
+// in memory even at a bit per cell. Prints an error and returns false if
+// the file can't be read or the work file can't be made.
+//
+// The floor is copied into a work file, mapped, which then holds the
+// state of the solve: the cells not yet covered. Passes of forced domino
+// placement, as reduce_floor does, sweep the work file a strip at a time,
+// alternately down and up, so that every pass reads and writes the file
+// in order. A strip sees the row on either side of it; a domino it places
+// across its edge changes the next strip, which the following pass picks
+// up, and strips nothing has changed since they were last reduced are
+// skipped. Once a pass places nothing, what is left is handed row by row
+// to a StreamTiling in one last pass. Memory then only needs to hold the
+// rooms that survive the reduction, as StreamTiling keeps them.
+bool has_tiling_out_of_core(const string &path, const OutOfCoreOptions &options = OutOfCoreOptions());
+
+#endif
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include "packed_floor.h"
+#include "tiling.h"
+
+using namespace std;
+
+static const size_t HeaderBytes = 16;
+
+// Row words are used in place, so the host must be little-endian, as
+// every platform this project builds for is.
+
+static void put16(string &out, uint16_t value)
+{
+	out += static_cast<char>(value & 0xFF);
+	out += static_cast<char>(value >> 8);
+}
+
+static void put32(string &out, uint32_t value)
+{
+	for (int k = 0; k < 4; ++k)
+		out += static_cast<char>((value >> (8 * k)) & 0xFF);
+}
+
+static uint32_t get32(const unsigned char *bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+// Counts the lines of a text floor and the cells of its longest line.
+static void text_shape(string_view floor, uint32_t &rows, uint32_t &columns)
+{
+	rows = 0;
+	columns = 0;
+	uint32_t column = 0;
+	bool inLine = false;
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			rows++;
+			columns = max(columns, column);
+			column = 0;
+			inLine = false;
+			continue;
+		}
+		inLine = true;
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+	if (inLine)
+	{
+		rows++;
+		columns = max(columns, column);
+	}
+}
+
+size_t packed_bytes(uint32_t rows, uint32_t columns)
+{
+	return HeaderBytes + size_t(rows) * ((size_t(columns) + 63) / 64) * 8;
+}
+
+void pack_floor(string_view floor, string &out, uint16_t flags)
+{
+	uint32_t rows, columns;
+	text_shape(floor, rows, columns);
+	size_t wordsPerRow = (size_t(columns) + 63) / 64;
+
+	out += "HWTB";
+	put16(out, PackedVersion);
+	put16(out, flags);
+	put32(out, rows);
+	put32(out, columns);
+
+	size_t start = out.length();
+	out.resize(start + size_t(rows) * wordsPerRow * 8, '\0');
+	unsigned char *cells = reinterpret_cast<unsigned char*>(&out[start]);
+	size_t row = 0;
+	size_t column = 0;
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			continue;
+		}
+		if (ch == ' ')
+		{
+			size_t bit = row * wordsPerRow * 64 + column;
+			cells[bit / 8] |= static_cast<unsigned char>(1 << (bit % 8));
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+}
+
+bool read_packed(string_view data, size_t &offset, PackedFloor &floor)
+{
+	if (offset >= data.length())
+		return false;
+	if (data.length() - offset < HeaderBytes || data.compare(offset, 4, "HWTB") != 0)
+	{
+		cerr << "read_packed() found no record at byte " << offset << "." << endl;
+		return false;
+	}
+	const unsigned char *header = reinterpret_cast<const unsigned char*>(data.data() + offset);
+	uint16_t version = static_cast<uint16_t>(header[4] | (header[5] << 8));
+	if (version != PackedVersion)
+	{
+		cerr << "read_packed() does not know version " << version << "." << endl;
+		return false;
+	}
+	floor.flags = static_cast<uint16_t>(header[6] | (header[7] << 8));
+	floor.rows = get32(header + 8);
+	floor.columns = get32(header + 12);
+	floor.wordsPerRow = (size_t(floor.columns) + 63) / 64;
+
+	size_t bytes = packed_bytes(floor.rows, floor.columns);
+	if (data.length() - offset < bytes)
+	{
+		cerr << "read_packed() found a record cut short at byte " << offset << "." << endl;
+		return false;
+	}
+	const char *cells = data.data() + offset + HeaderBytes;
+	if (reinterpret_cast<uintptr_t>(cells) % alignof(uint64_t) != 0)
+	{
+		cerr << "read_packed() needs 8-byte aligned data." << endl;
+		return false;
+	}
+	floor.words = reinterpret_cast<const uint64_t*>(cells);
+	offset += bytes;
+	return true;
+}
+
+void unpack_floor(const PackedFloor &floor, string &text)
+{
+	text.assign(size_t(floor.rows) * (size_t(floor.columns) + 1), '#');
+	char *out = &text[0];
+	const uint64_t *words = floor.words;
+	for (uint32_t r = 0; r < floor.rows; ++r, words += floor.wordsPerRow)
+	{
+		for (uint32_t c = 0; c < floor.columns; ++c)
+			if ((words[c / 64] >> (c % 64)) & 1)
+				out[c] = ' ';
+		out[floor.columns] = '\n';
+		out += size_t(floor.columns) + 1;
+	}
+}
+
+bool has_tiling_packed(const PackedFloor &floor)
+{
+	if (floor.columns <= 64)
+		return local_context().solve_rows(floor.words, floor.rows, static_cast<int>(floor.columns));
+
+	string text;
+	unpack_floor(floor, text);
+	return has_tiling(text);
+}
+
+// Skips whitespace and comments between the fields of a PBM header.
+static void skip_blanks(string_view data, size_t &at)
+{
+	while (at < data.length())
+	{
+		if (data[at] == '#')
+		{
+			while (at < data.length() && data[at] != '\n')
+				at++;
+		}
+		else if (isspace(static_cast<unsigned char>(data[at])))
+			at++;
+		else
+			return;
+	}
+}
+
+// Reads a decimal number, failing if there is none or it doesn't fit in
+// 32 bits.
+static bool read_number(string_view data, size_t &at, uint32_t &value)
+{
+	skip_blanks(data, at);
+	size_t start = at;
+	uint64_t number = 0;
+	while (at < data.length() && data[at] >= '0' && data[at] <= '9')
+	{
+		number = number * 10 + (data[at++] - '0');
+		if (number > UINT32_MAX)
+			return false;
+	}
+	value = static_cast<uint32_t>(number);
+	return at > start;
+}
+
+bool read_pbm(string_view data, size_t &offset, string &floor)
+{
+	size_t at = offset;
+	skip_blanks(data, at);
+	if (at >= data.length())
+		return false;
+
+	uint32_t width, height;
+	bool raw = data.compare(at, 2, "P4") == 0;
+	if ((!raw && data.compare(at, 2, "P1") != 0)
+		|| !read_number(data, at += 2, width) || !read_number(data, at, height))
+	{
+		cerr << "read_pbm() found no PBM header at byte " << offset << "." << endl;
+		return false;
+	}
+
+	// Every pixel takes at least a bit of a raw image and a byte of a
+	// plain one, so an image claiming more than the data holds is
+	// rejected before any room is made for it.
+	size_t line = size_t(width) + 1;
+	size_t rowBytes = (size_t(width) + 7) / 8;
+	if (raw)
+		at++;
+	size_t left = data.length() < at ? 0 : data.length() - at;
+	if (raw ? height > 0 && rowBytes > left / height : uint64_t(width) * height > left)
+	{
+		cerr << "read_pbm() found an image cut short." << endl;
+		return false;
+	}
+
+	floor.assign(size_t(height) * line, '\n');
+	if (raw)
+	{
+		// One whitespace byte, then rows of bits, high bit first, each
+		// row padded to a whole byte.
+		for (size_t r = 0; r < height; ++r)
+			for (size_t c = 0; c < width; ++c)
+			{
+				unsigned char byte = static_cast<unsigned char>(data[at + r * rowBytes + c / 8]);
+				floor[r * line + c] = (byte >> (7 - c % 8)) & 1 ? '#' : ' ';
+			}
+		at += rowBytes * height;
+	}
+	else
+	{
+		for (size_t cell = 0; cell < size_t(width) * height; ++cell)
+		{
+			skip_blanks(data, at);
+			if (at >= data.length() || (data[at] != '0' && data[at] != '1'))
+			{
+				cerr << "read_pbm() found an image cut short." << endl;
+				return false;
+			}
+			floor[cell / width * line + cell % width] = data[at++] == '1' ? '#' : ' ';
+		}
+	}
+	offset = at;
+	return true;
+}
+
+void write_pbm(string_view floor, string &out)
+{
+	uint32_t rows, columns;
+	text_shape(floor, rows, columns);
+	out += "P4\n" + to_string(columns) + " " + to_string(rows) + "\n";
+
+	// Start with every pixel black, so padding is wall.
+	size_t rowBytes = (size_t(columns) + 7) / 8;
+	size_t start = out.length();
+	out.resize(start + rowBytes * rows, '\xFF');
+	size_t row = 0;
+	size_t column = 0;
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			continue;
+		}
+		if (ch == ' ')
+			out[start + row * rowBytes + column / 8] &= static_cast<char>(~(0x80 >> (column % 8)));
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+}
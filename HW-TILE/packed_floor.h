@@ -0,0 +1,76 @@
+#ifndef PACKED_FLOOR_H
+#define PACKED_FLOOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Binary floor format, one bit per cell.
+//
+// A record is a 16-byte header followed by the cells:
+//
+//   bytes 0-3    "HWTB"
+//   bytes 4-5    version, 1
+//   bytes 6-7    flags (PackedFlags)
+//   bytes 8-11   rows
+//   bytes 12-15  columns
+//
+// then for each row, ceil(columns / 64) 64-bit words with bit c set when
+// column c is open. Bits past the last column are clear. Every field is
+// little-endian. Records follow each other with nothing in between, and
+// since each is a multiple of 8 bytes long, rows stay 8-byte aligned in
+// a file that is mapped or read whole, ready for use as row words.
+const uint16_t PackedVersion = 1;
+
+enum PackedFlags : uint16_t
+{
+	// The record also says whether the floor has a tiling.
+	PackedKnown = 1,
+	// The floor has a tiling, if PackedKnown is set.
+	PackedTiled = 2,
+};
+
+// A record read in place: words points into the data it was read from.
+struct PackedFloor
+{
+	uint32_t rows;
+	uint32_t columns;
+	uint16_t flags;
+	size_t wordsPerRow;
+	const uint64_t *words;
+};
+
+// Returns the size in bytes of the record for a floor of that shape.
+size_t packed_bytes(uint32_t rows, uint32_t columns);
+
+// Appends the record of a text floor to out. Rows are the floor's lines
+// and columns the longest line's count of ' ' and '#', as color_floor
+// counts them; shorter lines are padded with walls.
+void pack_floor(string_view floor, string &out, uint16_t flags = 0);
+
+// Reads the record starting at offset in data and moves offset past it.
+// Returns false at the end of data, or, printing an error, if the record
+// is malformed, cut short or not 8-byte aligned.
+bool read_packed(string_view data, size_t &offset, PackedFloor &floor);
+
+// Writes a record back as a text floor, every line ending in '\n'.
+void unpack_floor(const PackedFloor &floor, string &text);
+
+// Returns whether a packed floor has a tiling. Floors of at most 64
+// columns are handed to the fixed-width kernels as they are; wider ones
+// are unpacked first.
+bool has_tiling_packed(const PackedFloor &floor);
+
+// Reads a PBM image, plain (P1) or raw (P4), starting at offset in data,
+// and moves offset past it. Black pixels are walls and white ones open
+// cells. Returns false at the end of data, or, printing an error, if the
+// image is malformed.
+bool read_pbm(string_view data, size_t &offset, string &floor);
+
+// Appends a text floor to out as a raw PBM image.
+void write_pbm(string_view floor, string &out);
+
+#endif
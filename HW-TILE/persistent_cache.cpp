@@ -0,0 +1,264 @@
+#include <cstring>
+#include <iostream>
+#include "persistent_cache.h"
+#include "result_cache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// "HWTILE01" read as a little-endian word.
+static const uint64_t TableMagic = 0x3130454C49545748ULL;
+
+// The first cache line of the file.
+struct PersistentCache::Header
+{
+	uint64_t magic;
+	uint64_t capacity;
+	atomic<uint64_t> count;
+	char padding[40];
+};
+
+// A key of 0 marks an empty slot, a value of 0 a slot whose answer is
+// still being written. Otherwise bit 0 of the value is set, bit 1 holds
+// the answer and the other bits the check hash.
+struct PersistentCache::Slot
+{
+	atomic<uint64_t> key;
+	atomic<uint64_t> value;
+};
+
+static_assert(sizeof(atomic<uint64_t>) == sizeof(uint64_t) && ATOMIC_LLONG_LOCK_FREE == 2,
+	"slots are shared between processes, so their atomics must be plain words");
+
+static uint64_t slot_key(string_view key)
+{
+	uint64_t hash = canonical_hash(key);
+	return hash ? hash : 1;
+}
+
+// A second hash, independent of the first, so that two canonical forms
+// sharing a slot key are still told apart.
+static uint64_t slot_value(string_view key, bool answer)
+{
+	uint64_t hash = 0x84222325CBF29CE4ULL;
+	for (char ch : key)
+		hash = (hash ^ static_cast<unsigned char>(ch)) * 0x100000001B3ULL + 0x9E3779B97F4A7C15ULL;
+	return (hash & ~uint64_t(3)) | (answer ? 2 : 0) | 1;
+}
+
+static bool fail(const string &path, const char *what)
+{
+	cerr << "PersistentCache: " << what << " " << path << endl;
+	return false;
+}
+
+PersistentCache::PersistentCache(const string &path, size_t capacity)
+	: header(nullptr), slots(nullptr), mask(0), mappedBytes(0)
+{
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	file = -1;
+#endif
+	if (!open(path, capacity))
+		close();
+}
+
+bool PersistentCache::open(const string &path, size_t capacity)
+{
+	size_t slotCount = 16;
+	while (slotCount < capacity)
+		slotCount *= 2;
+
+	// A file too short for a header, or without a magic, is one whose
+	// creator died before finishing it: it is set up again from scratch.
+	// Only one process does that, and no one uses such a file meanwhile.
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return fail(path, "cannot open");
+
+	OVERLAPPED whole = {};
+	if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &whole))
+		return fail(path, "cannot lock");
+	LARGE_INTEGER length;
+	uint64_t words[2] = {};
+	DWORD got = 0;
+	bool read = GetFileSizeEx(file, &length) && ReadFile(file, words, sizeof(words), &got, NULL);
+	bool fresh = got != sizeof(words) || words[0] == 0;
+	bool ok = !read ? fail(path, "cannot read")
+		: set_up(path, fresh, fresh ? slotCount : static_cast<size_t>(words[1]), words[0],
+			static_cast<uint64_t>(length.QuadPart));
+	UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &whole);
+#else
+	file = ::open(path.c_str(), O_RDWR | O_CREAT, 0666);
+	if (file < 0)
+		return fail(path, "cannot open");
+
+	if (flock(file, LOCK_EX) != 0)
+		return fail(path, "cannot lock");
+	struct stat status;
+	uint64_t words[2] = {};
+	ssize_t got = fstat(file, &status) == 0 ? pread(file, words, sizeof(words), 0) : -1;
+	bool fresh = got != static_cast<ssize_t>(sizeof(words)) || words[0] == 0;
+	bool ok = got < 0 ? fail(path, "cannot read")
+		: set_up(path, fresh, fresh ? slotCount : static_cast<size_t>(words[1]), words[0],
+			static_cast<uint64_t>(status.st_size));
+	flock(file, LOCK_UN);
+#endif
+	return ok;
+}
+
+bool PersistentCache::set_up(const string &path, bool fresh, size_t slotCount, uint64_t magic, uint64_t length)
+{
+	if (!fresh && (magic != TableMagic || slotCount < 16 || (slotCount & (slotCount - 1)) != 0))
+		return fail(path, "not a result table:");
+	mappedBytes = sizeof(Header) + slotCount * sizeof(Slot);
+	if (!fresh && length < mappedBytes)
+		return fail(path, "truncated result table:");
+
+	// Whatever a fresh file held is dropped, so that it reads as zeros,
+	// which is an empty table.
+#ifdef _WIN32
+	if (fresh)
+	{
+		LARGE_INTEGER zero = {};
+		if (!SetFilePointerEx(file, zero, NULL, FILE_BEGIN) || !SetEndOfFile(file))
+			return fail(path, "cannot clear");
+	}
+	ULARGE_INTEGER bytes;
+	bytes.QuadPart = mappedBytes;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, bytes.HighPart, bytes.LowPart, NULL);
+	void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappedBytes) : NULL;
+	if (!view)
+		return fail(path, "cannot map");
+#else
+	if (fresh && (ftruncate(file, 0) != 0 || ftruncate(file, static_cast<off_t>(mappedBytes)) != 0))
+		return fail(path, "cannot grow");
+	void *view = mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	if (view == MAP_FAILED)
+		return fail(path, "cannot map");
+#endif
+
+	header = static_cast<Header*>(view);
+	slots = reinterpret_cast<Slot*>(header + 1);
+	mask = slotCount - 1;
+
+	// The magic goes in last so that a table cut short by a crash is set
+	// up again by the next process to open it.
+	if (fresh)
+	{
+		header->capacity = slotCount;
+		header->magic = TableMagic;
+	}
+	return true;
+}
+
+void PersistentCache::close()
+{
+#ifdef _WIN32
+	if (header)
+		UnmapViewOfFile(header);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	if (header)
+		munmap(header, mappedBytes);
+	if (file >= 0)
+		::close(file);
+	file = -1;
+#endif
+	header = nullptr;
+	slots = nullptr;
+	mask = 0;
+	mappedBytes = 0;
+}
+
+bool PersistentCache::is_open() const
+{
+	return header != nullptr;
+}
+
+PersistentCache::~PersistentCache()
+{
+	close();
+}
+
+bool PersistentCache::find(string_view key, bool &answer) const
+{
+	if (!header)
+		return false;
+	uint64_t wanted = slot_key(key);
+	uint64_t check = slot_value(key, false) & ~uint64_t(3);
+	for (size_t i = wanted & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes)
+	{
+		uint64_t seen = slots[i].key.load(memory_order_acquire);
+		if (seen == 0)
+			return false;
+		if (seen != wanted)
+			continue;
+
+		uint64_t value = slots[i].value.load(memory_order_acquire);
+		if (value == 0)
+			return false;
+		if ((value & ~uint64_t(3)) == check)
+		{
+			answer = (value & 2) != 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PersistentCache::insert(string_view key, bool answer)
+{
+	if (!header || header->count.load(memory_order_relaxed) >= (mask + 1) / 4 * 3)
+		return false;
+
+	uint64_t wanted = slot_key(key);
+	uint64_t value = slot_value(key, answer);
+	for (size_t i = wanted & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes)
+	{
+		uint64_t seen = slots[i].key.load(memory_order_acquire);
+		if (seen == 0 && slots[i].key.compare_exchange_strong(seen, wanted, memory_order_acq_rel))
+		{
+			slots[i].value.store(value, memory_order_release);
+			header->count.fetch_add(1, memory_order_relaxed);
+			return true;
+		}
+		if (seen != wanted)
+			continue;
+
+		// Either the same form, possibly still being written, or another
+		// form with the same slot key.
+		uint64_t stored = slots[i].value.load(memory_order_acquire);
+		if (stored == 0 || (stored & ~uint64_t(3)) == (value & ~uint64_t(3)))
+			return false;
+	}
+	return false;
+}
+
+size_t PersistentCache::size() const
+{
+	return header ? static_cast<size_t>(header->count.load(memory_order_relaxed)) : 0;
+}
+
+size_t PersistentCache::capacity() const
+{
+	return header ? mask + 1 : 0;
+}
@@ -0,0 +1,71 @@
+#ifndef PERSISTENT_CACHE_H
+#define PERSISTENT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Answers kept in a file that every process on the host maps into memory,
+// so that restarted and sibling processes reuse each other's results.
+//
+// The file is an open-addressing hash table with linear probing. Each slot
+// holds the hash of a canonical form and, filled in after it, a second
+// check hash together with the answer. Inserting claims a slot with one
+// compare-and-swap and publishes the answer with one release store;
+// readers never lock. Entries are never removed: once the table is three
+// quarters full, new answers are simply not stored.
+class PersistentCache
+{
+public:
+	// Opens the table at path, creating it with room for capacity entries
+	// (rounded up to a power of two) if it doesn't exist yet. An existing
+	// table keeps its own capacity, and a file left empty or half made by
+	// a process that died setting it up is set up again. If the file
+	// can't be mapped or isn't a table, the reason goes to cerr and the
+	// cache is left closed: it finds nothing and stores nothing.
+	explicit PersistentCache(const string &path, size_t capacity = 1 << 20);
+	~PersistentCache();
+
+	// Whether the table file was opened.
+	bool is_open() const;
+
+	PersistentCache(const PersistentCache&) = delete;
+	PersistentCache& operator=(const PersistentCache&) = delete;
+
+	// Looks up a canonical form. Returns false if it isn't stored, or if
+	// another process is still writing its answer.
+	bool find(string_view key, bool &answer) const;
+
+	// Stores the answer for a canonical form. Returns false if it was
+	// already stored or the table is full.
+	bool insert(string_view key, bool answer);
+
+	// Number of entries stored and number of slots, both 0 if closed.
+	size_t size() const;
+	size_t capacity() const;
+
+private:
+	struct Header;
+	struct Slot;
+
+	bool open(const string &path, size_t capacity);
+	bool set_up(const string &path, bool fresh, size_t slotCount, uint64_t magic, uint64_t length);
+	void close();
+
+	Header *header;
+	Slot *slots;
+	size_t mask;
+	size_t mappedBytes;
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#else
+	int file;
+#endif
+};
+
+#endif
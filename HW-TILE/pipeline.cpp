@@ -0,0 +1,168 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "pipeline.h"
+#include "tiling.h"
+
+using namespace std;
+
+// A floor travelling between stages.
+struct PipelineItem
+{
+	size_t index;
+	// The colored floor, reduced in place by the reduce stage.
+	string colored;
+	// Set once some stage has decided the floor.
+	Reduction state;
+};
+
+// A queue between two stages, along with how many of the
+// producing stage's threads are still running.
+//
+// Items go through the lock-free queue; a thread only takes the lock to
+// sleep when the queue is full or empty, and the other side only takes
+// it to wake someone up when a thread is asleep.
+struct StageLink
+{
+	BoundedQueue<PipelineItem> items;
+	atomic<unsigned> producers;
+	// Threads asleep in push or pop.
+	atomic<unsigned> sleepers;
+	mutex lock;
+	condition_variable changed;
+
+	StageLink(size_t capacity, unsigned numProducers)
+		: items(capacity), producers(numProducers), sleepers(0)
+	{
+	}
+
+	void push(PipelineItem &item)
+	{
+		if (!items.try_push(item))
+			sleep_until([&] { return items.try_push(item); });
+		wake();
+	}
+
+	// Returns false once the queue is empty and will stay empty.
+	bool pop(PipelineItem &item)
+	{
+		bool popped = items.try_pop(item);
+		if (!popped)
+			sleep_until([&]
+			{
+				popped = items.try_pop(item);
+				return popped || producers.load() == 0;
+			});
+		if (popped)
+			wake();
+		return popped;
+	}
+
+	// Called by each producing thread when it is done.
+	void finish_producer()
+	{
+		producers.fetch_sub(1);
+		atomic_thread_fence(memory_order_seq_cst);
+		if (sleepers.load() > 0)
+		{
+			lock_guard<mutex> guard(lock);
+			changed.notify_all();
+		}
+	}
+
+private:
+	template <class Ready>
+	void sleep_until(Ready ready)
+	{
+		unique_lock<mutex> guard(lock);
+		sleepers.fetch_add(1);
+		// Checked again after announcing the sleep, so a change made in
+		// between is either seen here or followed by a wake-up.
+		atomic_thread_fence(memory_order_seq_cst);
+		changed.wait(guard, ready);
+		sleepers.fetch_sub(1);
+	}
+
+	void wake()
+	{
+		atomic_thread_fence(memory_order_seq_cst);
+		if (sleepers.load() > 0)
+		{
+			lock_guard<mutex> guard(lock);
+			changed.notify_all();
+		}
+	}
+};
+
+void run_pipeline(const function<bool(string &floor)> &next,
+	const function<void(size_t, bool)> &onResult,
+	const PipelineOptions &options)
+{
+	unsigned parseThreads = options.parseThreads > 0 ? options.parseThreads : 1;
+	unsigned reduceThreads = options.reduceThreads > 0 ? options.reduceThreads : 1;
+	unsigned solveThreads = options.solveThreads > 0 ? options.solveThreads : 1;
+
+	StageLink parsed(options.queueCapacity, parseThreads);
+	StageLink reduced(options.queueCapacity, reduceThreads);
+
+	mutex sourceLock;
+	size_t produced = 0;
+	mutex reportLock;
+
+	vector<thread> threads;
+
+	for (unsigned t = 0; t < parseThreads; ++t)
+		threads.emplace_back([&]
+		{
+			string floor;
+			while (true)
+			{
+				PipelineItem item;
+				{
+					lock_guard<mutex> guard(sourceLock);
+					if (!next(floor))
+						break;
+					item.index = produced++;
+				}
+				color_floor(floor, item.colored);
+				item.state = Reduction::Undecided;
+				parsed.push(item);
+			}
+			parsed.finish_producer();
+		});
+
+	for (unsigned t = 0; t < reduceThreads; ++t)
+		threads.emplace_back([&]
+		{
+			PipelineItem item;
+			while (parsed.pop(item))
+			{
+				item.state = reduce_floor(item.colored);
+				reduced.push(item);
+			}
+			reduced.finish_producer();
+		});
+
+	for (unsigned t = 0; t < solveThreads; ++t)
+		threads.emplace_back([&]
+		{
+			PipelineItem item;
+			while (reduced.pop(item))
+			{
+				bool answer;
+				if (item.state == Reduction::Undecided)
+					answer = local_context().match_rooms(item.colored);
+				else
+					answer = item.state == Reduction::Tiled;
+
+				lock_guard<mutex> guard(reportLock);
+				onResult(item.index, answer);
+			}
+		});
+
+	for (thread &t : threads)
+		t.join();
+}
@@ -0,0 +1,36 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+using namespace std;
+
+// Number of threads given to each stage of run_pipeline, and the
+// capacity of the queues between the stages.
+struct PipelineOptions
+{
+	// Threads reading floors from the source and coloring them.
+	unsigned parseThreads = 1;
+	// Threads placing forced dominoes.
+	unsigned reduceThreads = 1;
+	// Threads matching whatever the reduction left open.
+	unsigned solveThreads = 1;
+	// Floors that may wait between two stages.
+	size_t queueCapacity = 1024;
+};
+
+// Decides a stream of floors with every stage of the solver running on
+// its own threads, so reading input overlaps with solving.
+//
+// The parse stage calls next(floor) to get each floor in turn; next
+// returns false once the stream is exhausted. Calls to next are made one
+// at a time, so it may read from a file or socket without locking. The
+// i-th floor produced is reported as onResult(i, answer), in completion
+// order and one call at a time. Returns once every floor is reported.
+void run_pipeline(const function<bool(string &floor)> &next,
+	const function<void(size_t, bool)> &onResult,
+	const PipelineOptions &options = PipelineOptions());
+
+#endif
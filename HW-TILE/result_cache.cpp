@@ -0,0 +1,265 @@
+#include <algorithm>
+#include "floor.h"
+#include "persistent_cache.h"
+#include "result_cache.h"
+#include "small_floor.h"
+#include "tiling.h"
+
+using namespace std;
+
+string canonical_form(string_view floor)
+{
+	// Bounding box of the open cells, columns counted as in color_floor.
+	int top = -1, bottom = -1, left = 0, right = -1;
+	int row = 0, column = 0;
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			continue;
+		}
+		if (ch == ' ')
+		{
+			if (top < 0)
+			{
+				top = row;
+				left = right = column;
+			}
+			left = min(left, column);
+			right = max(right, column);
+			bottom = row;
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+	if (top < 0)
+		return string();
+
+	int R = bottom - top + 1;
+	int C = right - left + 1;
+	vector<char> cells(static_cast<size_t>(R) * C, 0);
+	row = 0;
+	column = 0;
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			continue;
+		}
+		if (ch == ' ')
+			cells[static_cast<size_t>(row - top) * C + (column - left)] = 1;
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+
+	// Encode every rotation and reflection as its dimensions followed by
+	// its cells, eight to a byte, and keep the smallest.
+	string best;
+	string candidate;
+	for (int t = 0; t < 8; ++t)
+	{
+		bool swapped = t == 1 || t == 3 || t == 6 || t == 7;
+		int rows = swapped ? C : R;
+		int cols = swapped ? R : C;
+
+		candidate.assign(8, '\0');
+		for (int k = 0; k < 4; ++k)
+		{
+			candidate[k] = static_cast<char>((rows >> (8 * k)) & 0xFF);
+			candidate[4 + k] = static_cast<char>((cols >> (8 * k)) & 0xFF);
+		}
+
+		unsigned char byte = 0;
+		int filled = 0;
+		for (int i = 0; i < rows; ++i)
+			for (int j = 0; j < cols; ++j)
+			{
+				int r, c;
+				switch (t)
+				{
+				case 0: r = i; c = j; break;                  // as is
+				case 1: r = R - 1 - j; c = i; break;          // quarter turn
+				case 2: r = R - 1 - i; c = C - 1 - j; break;  // half turn
+				case 3: r = j; c = C - 1 - i; break;          // three quarters
+				case 4: r = i; c = C - 1 - j; break;          // mirrored
+				case 5: r = R - 1 - i; c = j; break;          // flipped
+				case 6: r = j; c = i; break;                  // transposed
+				default: r = R - 1 - j; c = C - 1 - i; break; // anti-transposed
+				}
+				byte = static_cast<unsigned char>(byte | (cells[static_cast<size_t>(r) * C + c] << filled));
+				if (++filled == 8)
+				{
+					candidate += static_cast<char>(byte);
+					byte = 0;
+					filled = 0;
+				}
+			}
+		if (filled > 0)
+			candidate += static_cast<char>(byte);
+
+		if (t == 0 || candidate < best)
+			best.swap(candidate);
+	}
+	return best;
+}
+
+uint64_t canonical_hash(string_view key)
+{
+	// 64-bit FNV-1a.
+	uint64_t hash = 14695981039346656037ULL;
+	for (char ch : key)
+	{
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+ResultCache::ResultCache(size_t capacity, unsigned numShards)
+	: backing(nullptr), hits(0), misses(0), waits(0)
+{
+	if (numShards == 0)
+		numShards = 1;
+	for (unsigned i = 0; i < numShards; ++i)
+		shards.push_back(make_unique<Shard>());
+	shardCapacity = max<size_t>(1, capacity / numShards);
+}
+
+bool ResultCache::has_tiling(string_view floor)
+{
+	vector<string> rooms = split_components(floor);
+	for (const string &room : rooms)
+	{
+		SmallFloor small;
+		bool answer;
+		if (load_small_floor(room, small))
+			answer = small_has_tiling(small);
+		else
+			answer = lookup(canonical_form(room), room);
+		if (!answer)
+			return false;
+	}
+	return true;
+}
+
+bool ResultCache::lookup(const string &key, string_view component)
+{
+	Shard &shard = *shards[canonical_hash(key) % shards.size()];
+	shared_ptr<Pending> pending;
+	{
+		lock_guard<mutex> guard(shard.lock);
+		auto found = shard.entries.find(key);
+		if (found != shard.entries.end())
+		{
+			shard.order.splice(shard.order.begin(), shard.order, found->second);
+			hits.fetch_add(1, memory_order_relaxed);
+			return found->second->second;
+		}
+
+		auto flying = shard.inFlight.find(key);
+		if (flying != shard.inFlight.end())
+			pending = flying->second;
+		else
+			shard.inFlight[key] = make_shared<Pending>();
+	}
+
+	// Someone else is already solving it.
+	if (pending)
+	{
+		waits.fetch_add(1, memory_order_relaxed);
+		unique_lock<mutex> guard(pending->lock);
+		pending->ready.wait(guard, [&pending] { return pending->done; });
+		return pending->answer;
+	}
+
+	bool answer;
+	if (backing && backing->find(key, answer))
+		hits.fetch_add(1, memory_order_relaxed);
+	else
+	{
+		misses.fetch_add(1, memory_order_relaxed);
+		answer = local_context().solve(component);
+		if (backing)
+			backing->insert(key, answer);
+	}
+
+	{
+		lock_guard<mutex> guard(shard.lock);
+		store(shard, key, answer);
+		auto flying = shard.inFlight.find(key);
+		pending = flying->second;
+		shard.inFlight.erase(flying);
+	}
+	{
+		lock_guard<mutex> guard(pending->lock);
+		pending->done = true;
+		pending->answer = answer;
+	}
+	pending->ready.notify_all();
+	return answer;
+}
+
+void ResultCache::store(Shard &shard, const string &key, bool answer)
+{
+	if (shard.entries.count(key) > 0)
+		return;
+
+	shard.order.emplace_front(key, answer);
+	shard.entries[shard.order.front().first] = shard.order.begin();
+
+	if (shard.order.size() > shardCapacity)
+	{
+		shard.entries.erase(shard.order.back().first);
+		shard.order.pop_back();
+	}
+}
+
+ResultCache::Stats ResultCache::stats() const
+{
+	Stats s;
+	s.hits = hits.load();
+	s.misses = misses.load();
+	s.waits = waits.load();
+	return s;
+}
+
+size_t ResultCache::size() const
+{
+	size_t total = 0;
+	for (const unique_ptr<Shard> &shard : shards)
+	{
+		lock_guard<mutex> guard(shard->lock);
+		total += shard->order.size();
+	}
+	return total;
+}
+
+void ResultCache::clear()
+{
+	for (unique_ptr<Shard> &shard : shards)
+	{
+		lock_guard<mutex> guard(shard->lock);
+		shard->entries.clear();
+		shard->order.clear();
+	}
+}
+
+void ResultCache::persist_to(PersistentCache *store)
+{
+	backing = store;
+}
+
+ResultCache& default_cache()
+{
+	static ResultCache cache;
+	return cache;
+}
+
+bool has_tiling_cached(string_view floor)
+{
+	return default_cache().has_tiling(floor);
+}
@@ -0,0 +1,114 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class PersistentCache;
+
+// Returns a key shared by a floor and all its rotations and mirror images.
+//
+// The open cells are cropped to their bounding box, and of the 8 ways to
+// rotate or reflect the box, the one giving the smallest encoding wins.
+// Two floors have the same key exactly when one can be turned into the
+// other, so they also have the same answer.
+string canonical_form(string_view floor);
+
+// Returns a 64-bit hash of a canonical form.
+uint64_t canonical_hash(string_view key);
+
+// Concurrent cache of answers, keyed by the canonical form of each
+// connected component of a floor.
+//
+// Entries are spread over shards, each with its own lock and its own
+// least-recently-used order. When several threads ask about the same
+// component at once, one solves it and the others wait for its answer.
+class ResultCache
+{
+public:
+	// Holds at most capacity components in all.
+	explicit ResultCache(size_t capacity = 1 << 20, unsigned numShards = 64);
+
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	// Returns whether the floor has a tiling. Each component is looked up
+	// by its canonical form and solved only on a miss. Components small
+	// enough for small_has_tiling are solved directly, as that is cheaper
+	// than computing their key.
+	bool has_tiling(string_view floor);
+
+	// Returns the answer for a canonical form, solving and storing it
+	// on a miss.
+	bool lookup(const string &key, string_view component);
+
+	// Number of components found in the cache, solved, and waited for.
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t waits;
+	};
+	Stats stats() const;
+
+	// Returns the number of cached components.
+	size_t size() const;
+
+	// Removes every entry.
+	void clear();
+
+	// Also looks components up in store before solving them, and writes
+	// newly solved ones to it, so that answers outlive the process. Answers
+	// found there count as hits. Pass nullptr to stop; not to be called
+	// while other threads use the cache.
+	void persist_to(PersistentCache *store);
+
+private:
+	// A component being solved by some thread.
+	struct Pending
+	{
+		mutex lock;
+		condition_variable ready;
+		bool done = false;
+		bool answer = false;
+	};
+
+	struct Shard
+	{
+		mutable mutex lock;
+		// Most recently used first.
+		list<pair<string, bool>> order;
+		unordered_map<string_view, list<pair<string, bool>>::iterator> entries;
+		unordered_map<string, shared_ptr<Pending>> inFlight;
+	};
+
+	vector<unique_ptr<Shard>> shards;
+	size_t shardCapacity;
+	PersistentCache *backing;
+
+	atomic<uint64_t> hits;
+	atomic<uint64_t> misses;
+	atomic<uint64_t> waits;
+
+	void store(Shard &shard, const string &key, bool answer);
+};
+
+// Returns whether the floor has a tiling, going through a cache shared
+// by the whole process.
+bool has_tiling_cached(string_view floor);
+
+// Returns the process-wide cache used by has_tiling_cached.
+ResultCache& default_cache();
+
+#endif
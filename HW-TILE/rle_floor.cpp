@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include "rle_floor.h"
+#include "tiling.h"
+
+using namespace std;
+
+// Reads a decimal number at text[at], skipping spaces and tabs first.
+static bool read_count(string_view text, size_t &at, uint64_t &value)
+{
+	while (at < text.length() && (text[at] == ' ' || text[at] == '\t'))
+		at++;
+	size_t start = at;
+	value = 0;
+	while (at < text.length() && text[at] >= '0' && text[at] <= '9')
+		value = value * 10 + (text[at++] - '0');
+	return at > start;
+}
+
+static bool malformed(size_t offset, const char *what)
+{
+	cerr << "read_rle() " << what << " in the record at byte " << offset << "." << endl;
+	return false;
+}
+
+bool read_rle(string_view text, size_t &offset, RunFloor &floor)
+{
+	size_t at = offset;
+	while (at < text.length() && (text[at] == '\n' || text[at] == '\r' || text[at] == ' '))
+		at++;
+	if (at >= text.length())
+		return false;
+
+	uint64_t rows, columns;
+	if (text.compare(at, 3, "rle") != 0 || !read_count(text, at += 3, rows) || !read_count(text, at, columns)
+		|| rows > UINT32_MAX || columns > UINT32_MAX)
+		return malformed(offset, "found no header");
+	at = text.find('\n', at);
+	at = at == string_view::npos ? text.length() : at + 1;
+
+	floor.rows = static_cast<uint32_t>(rows);
+	floor.columns = static_cast<uint32_t>(columns);
+	floor.rowStart.assign(1, 0);
+	floor.runs.clear();
+
+	while (floor.rowStart.size() <= rows)
+	{
+		if (at >= text.length())
+			return malformed(offset, "is cut short");
+		size_t lineEnd = text.find('\n', at);
+		if (lineEnd == string_view::npos)
+			lineEnd = text.length();
+		string_view line = text.substr(at, lineEnd - at);
+		at = lineEnd + 1;
+
+		size_t pos = 0;
+		uint64_t repeat = 1;
+		size_t colon = line.find(':');
+		if (colon != string_view::npos)
+		{
+			if (!read_count(line, pos, repeat) || pos != colon)
+				return malformed(offset, "has a bad repeat");
+			pos = colon + 1;
+		}
+		if (repeat > rows + 1 - floor.rowStart.size())
+			return malformed(offset, "repeats past its last row");
+
+		size_t first = floor.runs.size();
+		uint64_t column = 0;
+		uint64_t length;
+		bool open = false;
+		while (read_count(line, pos, length))
+		{
+			if (column + length > columns)
+				return malformed(offset, "has a row longer than its columns");
+			// An empty wall run joins the open runs on either side, as
+			// encode_runs would have written them.
+			if (open && length > 0 && floor.runs.size() > first && floor.runs.back().end == column)
+				floor.runs.back().end = static_cast<uint32_t>(column + length);
+			else if (open && length > 0)
+				floor.runs.push_back(Run{ static_cast<uint32_t>(column), static_cast<uint32_t>(column + length) });
+			column += length;
+			open = !open;
+		}
+		while (pos < line.length() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r'))
+			pos++;
+		if (pos != line.length())
+			return malformed(offset, "has a bad row");
+
+		size_t last = floor.runs.size();
+		floor.rowStart.push_back(last);
+		for (uint64_t k = 1; k < repeat; ++k)
+		{
+			for (size_t i = first; i < last; ++i)
+				floor.runs.push_back(floor.runs[i]);
+			floor.rowStart.push_back(floor.runs.size());
+		}
+	}
+	offset = min(at, text.length());
+	return true;
+}
+
+// Returns whether rows a and b have the same runs.
+static bool same_row(const RunFloor &floor, uint32_t a, uint32_t b)
+{
+	size_t length = floor.rowStart[a + 1] - floor.rowStart[a];
+	if (length != floor.rowStart[b + 1] - floor.rowStart[b])
+		return false;
+	for (size_t k = 0; k < length; ++k)
+	{
+		const Run &x = floor.runs[floor.rowStart[a] + k];
+		const Run &y = floor.runs[floor.rowStart[b] + k];
+		if (x.begin != y.begin || x.end != y.end)
+			return false;
+	}
+	return true;
+}
+
+void write_rle(const RunFloor &floor, string &out)
+{
+	out += "rle " + to_string(floor.rows) + " " + to_string(floor.columns) + "\n";
+	uint32_t r = 0;
+	while (r < floor.rows)
+	{
+		uint32_t repeat = 1;
+		while (r + repeat < floor.rows && same_row(floor, r, r + repeat))
+			repeat++;
+		if (repeat > 1)
+			out += to_string(repeat) + ":";
+
+		uint32_t column = 0;
+		for (size_t i = floor.rowStart[r]; i < floor.rowStart[r + 1]; ++i)
+		{
+			const Run &run = floor.runs[i];
+			out += (column > 0 || i > floor.rowStart[r] ? " " : "") + to_string(run.begin - column) + " " + to_string(run.end - run.begin);
+			column = run.end;
+		}
+		out += '\n';
+		r += repeat;
+	}
+}
+
+void encode_runs(string_view floor, RunFloor &runs)
+{
+	runs.rows = 0;
+	runs.columns = 0;
+	runs.rowStart.assign(1, 0);
+	runs.runs.clear();
+
+	uint32_t column = 0;
+	bool inLine = false;
+	auto endRow = [&]()
+	{
+		runs.rows++;
+		runs.columns = max(runs.columns, column);
+		runs.rowStart.push_back(runs.runs.size());
+		column = 0;
+		inLine = false;
+	};
+	for (char ch : floor)
+	{
+		if (ch == '\n')
+		{
+			endRow();
+			continue;
+		}
+		inLine = true;
+		if (ch == ' ')
+		{
+			size_t rowRuns = runs.runs.size() - runs.rowStart.back();
+			if (rowRuns > 0 && runs.runs.back().end == column)
+				runs.runs.back().end++;
+			else
+				runs.runs.push_back(Run{ column, column + 1 });
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+	if (inLine)
+		endRow();
+}
+
+void decode_runs(const RunFloor &runs, string &floor)
+{
+	size_t stride = size_t(runs.columns) + 1;
+	floor.assign(runs.rows * stride, '#');
+	for (uint32_t r = 0; r < runs.rows; ++r)
+	{
+		char *line = &floor[r * stride];
+		for (size_t i = runs.rowStart[r]; i < runs.rowStart[r + 1]; ++i)
+			fill(line + runs.runs[i].begin, line + runs.runs[i].end, ' ');
+		line[runs.columns] = '\n';
+	}
+}
+
+// Number of cells c in [begin, end) with r + c even.
+static uint64_t black_cells(uint32_t r, const Run &run)
+{
+	uint64_t first = run.begin + ((run.begin + r) & 1);
+	return first >= run.end ? 0 : (run.end - first + 1) / 2;
+}
+
+static size_t find_root(vector<size_t> &parent, size_t i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+bool has_tiling_runs(const RunFloor &floor)
+{
+	size_t numRuns = floor.runs.size();
+	vector<size_t> parent(numRuns);
+	iota(parent.begin(), parent.end(), size_t(0));
+
+	// Runs of neighboring rows that share a column touch.
+	for (uint32_t r = 0; r + 1 < floor.rows; ++r)
+	{
+		size_t a = floor.rowStart[r], aEnd = floor.rowStart[r + 1];
+		size_t b = floor.rowStart[r + 1], bEnd = floor.rowStart[r + 2];
+		while (a < aEnd && b < bEnd)
+		{
+			const Run &x = floor.runs[a];
+			const Run &y = floor.runs[b];
+			if (x.begin < y.end && y.begin < x.end)
+			{
+				size_t p = find_root(parent, a), q = find_root(parent, b);
+				if (p != q)
+					parent[max(p, q)] = min(p, q);
+			}
+			if (x.end < y.end)
+				a++;
+			else
+				b++;
+		}
+	}
+
+	// Tally each component from its runs.
+	struct Component
+	{
+		uint64_t open = 0;
+		uint64_t black = 0;
+		size_t numRuns = 0;
+		uint32_t top = UINT32_MAX, bottom = 0, left = UINT32_MAX, right = 0;
+		bool sameRuns = true;
+	};
+	vector<size_t> slot(numRuns);
+	vector<Component> components;
+	vector<uint32_t> runRow(numRuns);
+	for (uint32_t r = 0; r < floor.rows; ++r)
+		for (size_t i = floor.rowStart[r]; i < floor.rowStart[r + 1]; ++i)
+		{
+			runRow[i] = r;
+			size_t root = find_root(parent, i);
+			if (root == i)
+			{
+				slot[i] = components.size();
+				components.emplace_back();
+			}
+			else
+				slot[i] = slot[root];
+
+			Component &c = components[slot[i]];
+			const Run &run = floor.runs[i];
+			c.open += run.end - run.begin;
+			c.black += black_cells(r, run);
+			c.sameRuns &= c.numRuns == 0 || (run.begin == c.left && run.end == c.right + 1);
+			c.numRuns++;
+			c.top = min(c.top, r);
+			c.bottom = max(c.bottom, r);
+			c.left = min(c.left, run.begin);
+			c.right = max(c.right, run.end - 1);
+		}
+
+	for (const Component &c : components)
+		if (2 * c.black != c.open)
+			return false;
+
+	// A rectangle (one run per row, all alike) is balanced, so even, and
+	// any open rectangle with an even number of cells has a tiling. The
+	// other components are drawn out and solved one by one.
+	vector<size_t> order(numRuns);
+	iota(order.begin(), order.end(), size_t(0));
+	stable_sort(order.begin(), order.end(), [&slot](size_t x, size_t y) { return slot[x] < slot[y]; });
+
+	string room;
+	for (size_t k = 0; k < numRuns;)
+	{
+		const Component &c = components[slot[order[k]]];
+		bool rectangle = c.sameRuns && c.numRuns == size_t(c.bottom - c.top) + 1;
+		if (!rectangle)
+		{
+			size_t stride = size_t(c.right - c.left) + 4;
+			room.assign((size_t(c.bottom - c.top) + 3) * stride, '#');
+			for (size_t j = 0; j < room.length(); j += stride)
+				room[j + stride - 1] = '\n';
+			for (size_t j = k; j < k + c.numRuns; ++j)
+			{
+				const Run &run = floor.runs[order[j]];
+				char *line = &room[(size_t(runRow[order[j]] - c.top) + 1) * stride + 1 - c.left];
+				fill(line + run.begin, line + run.end, ' ');
+			}
+			if (!local_context().solve(room))
+				return false;
+		}
+		k += c.numRuns;
+	}
+	return true;
+}
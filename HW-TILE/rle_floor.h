@@ -0,0 +1,64 @@
+#ifndef RLE_FLOOR_H
+#define RLE_FLOOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Run-length encoded floor format, for huge floors that are mostly open
+// or mostly wall. A record is a header line followed by one line per row:
+//
+//   rle <rows> <columns>
+//   [<repeat>:] <wall> <open> <wall> <open> ...
+//
+// Each row line gives the lengths of alternating runs of wall and open
+// cells, starting with wall; cells past the last run are wall, so an
+// empty line is a row of walls. A "<repeat>:" prefix stands for that many
+// copies of the row, which keeps floors of billions of cells to a few
+// lines.
+
+// The open cells of row r from column begin up to, not including, end.
+struct Run
+{
+	uint32_t begin;
+	uint32_t end;
+};
+
+// A floor held as the open runs of each row, in column order.
+struct RunFloor
+{
+	uint32_t rows = 0;
+	uint32_t columns = 0;
+	// Runs of row r are runs[rowStart[r]] to runs[rowStart[r + 1] - 1].
+	vector<size_t> rowStart;
+	vector<Run> runs;
+};
+
+// Reads the record starting at offset in text and moves offset past it.
+// Returns false at the end of text, or, printing an error, if the record
+// is malformed.
+bool read_rle(string_view text, size_t &offset, RunFloor &floor);
+
+// Appends the record of a floor to out, folding equal rows into repeats.
+void write_rle(const RunFloor &floor, string &out);
+
+// Converts between runs and text floors. encode_runs counts columns as
+// color_floor does; decode_runs ends every line with '\n'.
+void encode_runs(string_view floor, RunFloor &runs);
+void decode_runs(const RunFloor &runs, string &floor);
+
+// Returns whether a run floor has a tiling, working on the runs as far
+// as it can. Runs are labeled into components with union-find, merging
+// overlapping runs of neighboring rows, and each component's black and
+// red cells are counted from the runs alone. A floor with an unbalanced
+// component has no tiling, and a component that is an open rectangle
+// needs no further look. Only the remaining components are expanded to
+// cells, one at a time and cropped to their own bounding box, to be
+// solved by TilingContext.
+bool has_tiling_runs(const RunFloor &floor);
+
+#endif
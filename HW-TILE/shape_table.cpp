@@ -0,0 +1,54 @@
+#include "shape_table.h"
+
+using namespace std;
+
+// One bit per window, 8 KiB in all.
+struct WindowTable
+{
+	uint64_t bits[(1 << 16) / 64];
+};
+
+// Fills the table in increasing order of the window mask. The first open
+// cell of a window must be covered together with its right or lower
+// neighbor, and removing either domino leaves a smaller mask whose
+// answer is already known.
+static constexpr WindowTable build_table()
+{
+	WindowTable table = {};
+	table.bits[0] = 1;
+	for (uint32_t m = 1; m < (1 << 16); ++m)
+	{
+		int first = 0;
+		while (!((m >> first) & 1))
+			++first;
+
+		bool tiled = false;
+		uint32_t self = uint32_t(1) << first;
+		if (first % WindowSide + 1 < WindowSide && (m & (self << 1)))
+		{
+			uint32_t rest = m & ~(self | (self << 1));
+			tiled = (table.bits[rest >> 6] >> (rest & 63)) & 1;
+		}
+		if (!tiled && first + WindowSide < WindowSide * WindowSide && (m & (self << WindowSide)))
+		{
+			uint32_t rest = m & ~(self | (self << WindowSide));
+			tiled = (table.bits[rest >> 6] >> (rest & 63)) & 1;
+		}
+		if (tiled)
+			table.bits[m >> 6] |= uint64_t(1) << (m & 63);
+	}
+	return table;
+}
+
+static constexpr WindowTable Table = build_table();
+
+// Spot checks, evaluated by the compiler.
+static_assert((Table.bits[0] & 1) == 1, "the empty window is tiled");
+static_assert(((Table.bits[0] >> 3) & 1) == 1, "a horizontal domino is tiled");
+static_assert(((Table.bits[0] >> 7) & 1) == 0, "three cells are not tiled");
+static_assert((Table.bits[0xFFFF >> 6] >> (0xFFFF & 63) & 1) == 1, "the full window is tiled");
+
+bool window_has_tiling(uint16_t cells)
+{
+	return (Table.bits[cells >> 6] >> (cells & 63)) & 1;
+}
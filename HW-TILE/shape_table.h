@@ -0,0 +1,18 @@
+#ifndef SHAPE_TABLE_H
+#define SHAPE_TABLE_H
+
+#include <cstdint>
+
+using namespace std;
+
+// Side of the square window covered by the shape table.
+const int WindowSide = 4;
+
+// Returns whether the open cells of a 4x4 window have a tiling, cell
+// (r, c) of the window being bit 4 * r + c of cells.
+//
+// The answer comes from a table of all 65536 windows built at compile
+// time, so the smallest floors need no search at all.
+bool window_has_tiling(uint16_t cells);
+
+#endif
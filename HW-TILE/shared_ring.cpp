@@ -0,0 +1,301 @@
+#ifdef __linux__
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "shared_ring.h"
+#include "tiling.h"
+
+using namespace std;
+
+// "HWRING01" read as a little-endian word.
+static const uint64_t RingMagic = 0x31304E4952574748ULL;
+
+// Life of a slot. Only the client holding a slot moves it out of Free,
+// into Submitted and back to Free; only the server moves it through
+// Solving to Done.
+enum SlotState : uint32_t
+{
+	Free = 0,
+	Claimed = 1,
+	Submitted = 2,
+	Solving = 3,
+	Done = 4,
+};
+
+struct alignas(64) RingHeader
+{
+	uint64_t magic;
+	uint64_t slotBytes;
+	uint32_t slotCount;
+	// Bumped on every submission; the server sleeps on it.
+	atomic<uint32_t> submitted;
+	atomic<uint32_t> serverAsleep;
+	atomic<uint32_t> stopping;
+	// Bumped whenever a slot is freed; clients out of slots sleep on it.
+	atomic<uint32_t> freed;
+	atomic<uint32_t> clientsAsleep;
+	// Where clients start looking for a free slot.
+	atomic<uint32_t> nextSlot;
+};
+
+struct alignas(64) RingSlot
+{
+	atomic<uint32_t> state;
+	// Set by a client about to sleep on state, so that the server only
+	// makes the wake-up call for a client that may be asleep.
+	atomic<uint32_t> waiting;
+	uint32_t answer;
+	uint64_t length;
+};
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t) && ATOMIC_INT_LOCK_FREE == 2,
+	"the ring is shared between processes, so its atomics must be plain words");
+
+static RingHeader* ring_header(void *base)
+{
+	return static_cast<RingHeader*>(base);
+}
+
+static RingSlot* ring_slot(void *base, unsigned slot)
+{
+	return reinterpret_cast<RingSlot*>(ring_header(base) + 1) + slot;
+}
+
+static char* ring_data(void *base, unsigned slot)
+{
+	RingHeader *header = ring_header(base);
+	char *first = reinterpret_cast<char*>(ring_slot(base, header->slotCount));
+	return first + slot * header->slotBytes;
+}
+
+// Sleeps while *word holds value. The futexes are not private, since the
+// words live in memory shared between processes.
+static void futex_wait(atomic<uint32_t> &word, uint32_t value)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, nullptr, nullptr, 0);
+}
+
+static void futex_wake(atomic<uint32_t> &word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void* map_ring(const string &path, int flags, size_t &bytes)
+{
+	int file = open(path.c_str(), flags, 0666);
+	if (file < 0)
+	{
+		cerr << "Cannot open ring " << path << ": " << strerror(errno) << endl;
+		abort();
+	}
+	if (bytes == 0)
+	{
+		struct stat status;
+		fstat(file, &status);
+		bytes = static_cast<size_t>(status.st_size);
+	}
+	else if (ftruncate(file, static_cast<off_t>(bytes)) != 0)
+	{
+		cerr << "Cannot size ring " << path << ": " << strerror(errno) << endl;
+		abort();
+	}
+	void *base = bytes >= sizeof(RingHeader) ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+	close(file);
+	if (base == MAP_FAILED)
+	{
+		cerr << "Cannot map ring " << path << endl;
+		abort();
+	}
+	return base;
+}
+
+SharedRingServer::SharedRingServer(const string &path, unsigned slotCount, size_t slotBytes)
+	: path(path)
+{
+	slotCount = max(slotCount, 1u);
+	slotBytes = (max<size_t>(slotBytes, 1) + 63) / 64 * 64;
+	mappedBytes = sizeof(RingHeader) + slotCount * (sizeof(RingSlot) + slotBytes);
+
+	// A fresh file reads as zeros: every slot is Free.
+	unlink(path.c_str());
+	base = map_ring(path, O_RDWR | O_CREAT | O_EXCL, mappedBytes);
+	RingHeader *header = ring_header(base);
+	header->slotBytes = slotBytes;
+	header->slotCount = slotCount;
+	atomic_thread_fence(memory_order_release);
+	header->magic = RingMagic;
+}
+
+SharedRingServer::~SharedRingServer()
+{
+	munmap(base, mappedBytes);
+	unlink(path.c_str());
+}
+
+void SharedRingServer::stop()
+{
+	RingHeader *header = ring_header(base);
+	header->stopping.store(1);
+	header->submitted.fetch_add(1);
+	futex_wake(header->submitted);
+}
+
+void SharedRingServer::serve(ThreadPool &pool)
+{
+	RingHeader *header = ring_header(base);
+	TaskGroup solving;
+	while (!header->stopping.load())
+	{
+		uint32_t seen = header->submitted.load();
+
+		// Each submitted floor is solved on a task of its own, so an answer
+		// goes back as soon as its floor is decided and the next scan
+		// doesn't wait for the floors still being solved.
+		bool found = false;
+		for (unsigned i = 0; i < header->slotCount; ++i)
+		{
+			RingSlot *slot = ring_slot(base, i);
+			uint32_t expected = Submitted;
+			if (slot->state.load(memory_order_relaxed) == Submitted
+				&& slot->state.compare_exchange_strong(expected, Solving, memory_order_acquire))
+			{
+				found = true;
+				solving.add();
+				pool.submit([this, i, &solving]
+				{
+					RingSlot *slot = ring_slot(base, i);
+					slot->answer = has_tiling(string_view(ring_data(base, i), slot->length));
+					// The client sets waiting before checking state, so one of
+					// the two sides always sees the other's write.
+					slot->state.store(Done);
+					if (slot->waiting.load())
+						futex_wake(slot->state);
+					solving.done();
+				});
+			}
+		}
+
+		if (!found)
+		{
+			// Clients check serverAsleep after bumping submitted, so one of
+			// the two sides always sees the other's write.
+			header->serverAsleep.store(1);
+			if (header->submitted.load() == seen)
+				futex_wait(header->submitted, seen);
+			header->serverAsleep.store(0);
+		}
+	}
+	solving.wait(pool);
+}
+
+SharedRingClient::SharedRingClient(const string &path)
+	: mappedBytes(0)
+{
+	base = map_ring(path, O_RDWR, mappedBytes);
+	RingHeader *header = ring_header(base);
+	if (header->magic != RingMagic)
+	{
+		cerr << "Not a ring: " << path << endl;
+		abort();
+	}
+	atomic_thread_fence(memory_order_acquire);
+}
+
+SharedRingClient::~SharedRingClient()
+{
+	munmap(base, mappedBytes);
+}
+
+unsigned SharedRingClient::acquire()
+{
+	RingHeader *header = ring_header(base);
+	for (;;)
+	{
+		uint32_t seen = header->freed.load();
+		uint32_t start = header->nextSlot.fetch_add(1, memory_order_relaxed);
+		for (unsigned k = 0; k < header->slotCount; ++k)
+		{
+			unsigned i = (start + k) % header->slotCount;
+			uint32_t expected = Free;
+			if (ring_slot(base, i)->state.compare_exchange_strong(expected, Claimed, memory_order_acquire))
+				return i;
+		}
+
+		header->clientsAsleep.fetch_add(1);
+		if (header->freed.load() == seen)
+			futex_wait(header->freed, seen);
+		header->clientsAsleep.fetch_sub(1);
+	}
+}
+
+char* SharedRingClient::slot_data(unsigned slot)
+{
+	return ring_data(base, slot);
+}
+
+size_t SharedRingClient::slot_capacity() const
+{
+	return ring_header(base)->slotBytes;
+}
+
+void SharedRingClient::submit(unsigned slot, size_t length)
+{
+	RingHeader *header = ring_header(base);
+	if (length > header->slotBytes)
+	{
+		cerr << "Floor of " << length << " bytes submitted to a slot of " << header->slotBytes << endl;
+		abort();
+	}
+	RingSlot *ringSlot = ring_slot(base, slot);
+	ringSlot->length = length;
+	ringSlot->state.store(Submitted, memory_order_release);
+
+	header->submitted.fetch_add(1);
+	if (header->serverAsleep.load())
+		futex_wake(header->submitted);
+}
+
+bool SharedRingClient::wait(unsigned slot)
+{
+	RingHeader *header = ring_header(base);
+	RingSlot *ringSlot = ring_slot(base, slot);
+	uint32_t state;
+	while ((state = ringSlot->state.load(memory_order_acquire)) != Done)
+	{
+		ringSlot->waiting.store(1);
+		if (ringSlot->state.load() == state)
+			futex_wait(ringSlot->state, state);
+	}
+	bool answer = ringSlot->answer != 0;
+
+	ringSlot->waiting.store(0, memory_order_relaxed);
+	ringSlot->state.store(Free, memory_order_release);
+	header->freed.fetch_add(1);
+	if (header->clientsAsleep.load())
+		futex_wake(header->freed);
+	return answer;
+}
+
+bool SharedRingClient::has_tiling(string_view floor)
+{
+	unsigned slot = acquire();
+	if (floor.size() > slot_capacity())
+	{
+		cerr << "Floor of " << floor.size() << " bytes does not fit a slot of " << slot_capacity() << endl;
+		abort();
+	}
+	memcpy(slot_data(slot), floor.data(), floor.size());
+	submit(slot, floor.size());
+	return wait(slot);
+}
+
+#endif
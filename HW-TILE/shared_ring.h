@@ -0,0 +1,83 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "thread_pool.h"
+
+using namespace std;
+
+// Submission ring shared between a solver process and its clients on the
+// same host, so that floors are never copied between processes.
+//
+// The ring is a file of fixed-size slots mapped by every process (put it
+// under /dev/shm to keep it in memory). A client claims a free slot,
+// writes a floor straight into it and submits it; the server solves the
+// floor where it lies and writes the answer back into the slot. Waiting
+// on either side sleeps on a futex in the shared mapping, and a side only
+// makes the wake-up system call when the other is actually asleep.
+//
+// A client that dies holding a slot leaves that slot lost until the ring
+// is recreated.
+class SharedRingServer
+{
+public:
+	// Creates the ring at path, replacing any previous one, with slotCount
+	// slots of slotBytes bytes each. Aborts if that fails.
+	SharedRingServer(const string &path, unsigned slotCount, size_t slotBytes);
+	~SharedRingServer();
+
+	SharedRingServer(const SharedRingServer&) = delete;
+	SharedRingServer& operator=(const SharedRingServer&) = delete;
+
+	// Solves submitted floors on the pool, each as its own task, until
+	// stop() is called, and then waits for the floors being solved.
+	void serve(ThreadPool &pool);
+
+	// Makes serve() return. Safe to call from any thread.
+	void stop();
+
+private:
+	string path;
+	void *base;
+	size_t mappedBytes;
+};
+
+class SharedRingClient
+{
+public:
+	// Opens the ring a server created at path. Aborts if that fails.
+	explicit SharedRingClient(const string &path);
+	~SharedRingClient();
+
+	SharedRingClient(const SharedRingClient&) = delete;
+	SharedRingClient& operator=(const SharedRingClient&) = delete;
+
+	// Claims a free slot, waiting for one if all are taken, and returns
+	// its number. The floor is then written to slot_data(slot), at most
+	// slot_capacity() bytes of it, and handed over with submit().
+	unsigned acquire();
+	char* slot_data(unsigned slot);
+	size_t slot_capacity() const;
+	void submit(unsigned slot, size_t length);
+
+	// Waits for the answer to a submitted slot and frees the slot.
+	bool wait(unsigned slot);
+
+	// Copies the floor into a slot, submits it and waits for the answer.
+	// Aborts if the floor doesn't fit in a slot.
+	bool has_tiling(string_view floor);
+
+private:
+	void *base;
+	size_t mappedBytes;
+};
+
+#endif
+
+#endif
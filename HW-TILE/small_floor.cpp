@@ -0,0 +1,160 @@
+#include <algorithm>
+#include "bits.h"
+#include "shape_table.h"
+#include "small_floor.h"
+
+using namespace std;
+
+static bool is_set(const uint64_t bits[2], int p)
+{
+	return (bits[p >> 6] >> (p & 63)) & 1;
+}
+
+bool load_small_floor(string_view floor, SmallFloor &small)
+{
+	// First pass: bounding box of the open cells, giving up once it
+	// grows past the limit. Columns are counted as in color_floor.
+	int top = -1, bottom = -1, left = 0, right = -1;
+	size_t topStart = 0;
+	int row = 0, column = 0;
+	size_t lineStart = 0;
+	for (size_t i = 0; i < floor.length(); ++i)
+	{
+		char ch = floor[i];
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			lineStart = i + 1;
+			continue;
+		}
+		if (ch == ' ')
+		{
+			if (top < 0)
+			{
+				top = row;
+				left = right = column;
+				topStart = lineStart;
+			}
+			left = min(left, column);
+			right = max(right, column);
+			bottom = row;
+			if ((bottom - top + 1) * (right - left + 1) > SmallFloorCells)
+				return false;
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+
+	small.bits[0] = small.bits[1] = 0;
+	if (top < 0)
+	{
+		small.rows = small.width = 0;
+		return true;
+	}
+	small.rows = bottom - top + 1;
+	small.width = right - left + 1;
+
+	// Second pass: set the bits, starting from the first open line.
+	row = top;
+	column = 0;
+	for (size_t i = topStart; i < floor.length() && row <= bottom; ++i)
+	{
+		char ch = floor[i];
+		if (ch == '\n')
+		{
+			row++;
+			column = 0;
+			continue;
+		}
+		if (ch == ' ')
+		{
+			int p = (row - top) * small.width + (column - left);
+			small.bits[p >> 6] |= uint64_t(1) << (p & 63);
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+	return true;
+}
+
+// Tries to match black cell b, rematching already matched black cells
+// along the way. Red cells in visited are not tried again.
+static bool augment(int b, const uint64_t adj[], int matchRed[], uint64_t &visited)
+{
+	uint64_t options = adj[b] & ~visited;
+	while (options != 0)
+	{
+		int r = lowest_bit(options);
+		options &= options - 1;
+		visited |= uint64_t(1) << r;
+		if (matchRed[r] < 0 || augment(matchRed[r], adj, matchRed, visited))
+		{
+			matchRed[r] = b;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool small_has_tiling(const SmallFloor &small)
+{
+	int cells = small.rows * small.width;
+
+	// Floors fitting in the shape table's window are looked up.
+	if (small.rows <= WindowSide && small.width <= WindowSide)
+	{
+		uint16_t window = 0;
+		for (int r = 0; r < small.rows; ++r)
+			window |= ((small.bits[0] >> (r * small.width)) & ((1u << small.width) - 1)) << (r * WindowSide);
+		return window_has_tiling(window);
+	}
+
+	// Number the black and red cells separately. Each color has at most
+	// 64 cells whenever the colors are balanced.
+	signed char redIndex[SmallFloorCells];
+	signed char blackCell[SmallFloorCells];
+	int numBlack = 0, numRed = 0;
+	for (int r = 0, p = 0; r < small.rows; ++r)
+		for (int c = 0; c < small.width; ++c, ++p)
+		{
+			if (!is_set(small.bits, p))
+				continue;
+			if ((r + c) % 2 == 0)
+				blackCell[numBlack++] = static_cast<signed char>(p);
+			else
+				redIndex[p] = static_cast<signed char>(numRed++);
+		}
+	if (numBlack != numRed)
+		return false;
+
+	// Red neighbors of every black cell, as a mask of red indices.
+	// The column checks keep neighbors from wrapping around rows.
+	uint64_t adj[64];
+	for (int b = 0; b < numBlack; ++b)
+	{
+		int p = blackCell[b];
+		int c = p % small.width;
+		adj[b] = 0;
+		if (p >= small.width && is_set(small.bits, p - small.width))
+			adj[b] |= uint64_t(1) << redIndex[p - small.width];
+		if (p + small.width < cells && is_set(small.bits, p + small.width))
+			adj[b] |= uint64_t(1) << redIndex[p + small.width];
+		if (c > 0 && is_set(small.bits, p - 1))
+			adj[b] |= uint64_t(1) << redIndex[p - 1];
+		if (c + 1 < small.width && is_set(small.bits, p + 1))
+			adj[b] |= uint64_t(1) << redIndex[p + 1];
+		if (adj[b] == 0)
+			return false;
+	}
+
+	int matchRed[64];
+	fill(matchRed, matchRed + numRed, -1);
+	for (int b = 0; b < numBlack; ++b)
+	{
+		uint64_t visited = 0;
+		if (!augment(b, adj, matchRed, visited))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+#ifndef SMALL_FLOOR_H
+#define SMALL_FLOOR_H
+
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+// Largest number of cells in the bounding box of a small floor.
+const int SmallFloorCells = 128;
+
+// The open cells of a floor, cropped to their bounding box and stored
+// row after row in two machine words: cell (r, c) of the box is bit
+// r * width + c, counting from the low bit of bits[0].
+struct SmallFloor
+{
+	uint64_t bits[2];
+	int rows;
+	int width;
+};
+
+// Reads the floor into small if the bounding box of its open cells holds
+// at most SmallFloorCells cells. Returns false as soon as it doesn't.
+bool load_small_floor(string_view floor, SmallFloor &small);
+
+// Returns whether a small floor has a tiling. Floors of at most 4x4 cells
+// are looked up with window_has_tiling; larger ones by finding a perfect
+// matching between their black and red cells with bitmask augmenting
+// paths. Everything lives on the stack; nothing is allocated.
+bool small_has_tiling(const SmallFloor &small);
+
+#endif
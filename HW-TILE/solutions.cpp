@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "solutions.h"
+#include "tiling.h"
+
+using namespace std;
+
+static const int Unreached = -1;
+
+bool find_tiling(string_view floor, string &tiled)
+{
+	color_floor(floor, tiled);
+	const int cells = static_cast<int>(tiled.length());
+	const int stride = static_cast<int>(tiled.find('\n')) + 1;
+	const int steps[4] = { 1, -1, stride, -stride };
+
+	// A cell's neighbor in direction d, or -1. The '\n' ending each line
+	// keeps horizontal steps from wrapping.
+	auto neighbor = [&](int cell, int d)
+	{
+		int next = cell + steps[d];
+		if (next < 0 || next >= cells || (tiled[next] != 'b' && tiled[next] != 'r'))
+			return -1;
+		return next;
+	};
+
+	vector<int> black;
+	int red = 0;
+	for (int cell = 0; cell < cells; ++cell)
+	{
+		if (tiled[cell] == 'b')
+			black.push_back(cell);
+		else if (tiled[cell] == 'r')
+			red++;
+	}
+	if (static_cast<int>(black.size()) != red)
+		return false;
+
+	// mate[cell] is the cell covered by the same domino, or -1.
+	vector<int> mate(cells, -1);
+	for (int b : black)
+		for (int d = 0; d < 4 && mate[b] < 0; ++d)
+		{
+			int r = neighbor(b, d);
+			if (r >= 0 && mate[r] < 0)
+			{
+				mate[b] = r;
+				mate[r] = b;
+			}
+		}
+
+	vector<int> layer(cells);
+	vector<int> queue;
+	vector<int> path;
+	vector<int> via;
+	vector<unsigned char> tried(cells);
+	int unmatched = 0;
+	for (int b : black)
+		unmatched += mate[b] < 0;
+
+	while (unmatched > 0)
+	{
+		// Layer the black cells by breadth-first search from the free ones.
+		queue.clear();
+		for (int b : black)
+		{
+			layer[b] = mate[b] < 0 ? 0 : Unreached;
+			if (mate[b] < 0)
+				queue.push_back(b);
+		}
+		bool found = false;
+		for (size_t head = 0; head < queue.size(); ++head)
+		{
+			int b = queue[head];
+			for (int d = 0; d < 4; ++d)
+			{
+				int r = neighbor(b, d);
+				if (r < 0)
+					continue;
+				int next = mate[r];
+				if (next < 0)
+					found = true;
+				else if (layer[next] == Unreached)
+				{
+					layer[next] = layer[b] + 1;
+					queue.push_back(next);
+				}
+			}
+		}
+		if (!found)
+			return false;
+
+		// Augment along disjoint shortest paths, searching depth first
+		// without recursion: path holds the black cells of the current
+		// path and via the red cell taken from each.
+		for (int b : black)
+			tried[b] = 0;
+		for (int start : black)
+		{
+			if (mate[start] >= 0)
+				continue;
+			path.assign(1, start);
+			via.clear();
+			while (!path.empty())
+			{
+				int b = path.back();
+				if (tried[b] == 4)
+				{
+					layer[b] = Unreached;
+					path.pop_back();
+					if (!via.empty())
+						via.pop_back();
+					continue;
+				}
+				int r = neighbor(b, tried[b]++);
+				if (r < 0)
+					continue;
+				int next = mate[r];
+				if (next < 0)
+				{
+					via.push_back(r);
+					for (size_t k = 0; k < path.size(); ++k)
+					{
+						mate[path[k]] = via[k];
+						mate[via[k]] = path[k];
+					}
+					unmatched--;
+					break;
+				}
+				if (layer[next] == layer[b] + 1)
+				{
+					via.push_back(r);
+					path.push_back(next);
+				}
+			}
+		}
+	}
+
+	for (int b : black)
+	{
+		int r = mate[b];
+		int first = min(b, r);
+		int second = max(b, r);
+		bool across = second - first == 1;
+		tiled[first] = across ? '<' : '^';
+		tiled[second] = across ? '>' : 'v';
+	}
+	return true;
+}
+
+// Nonnegative integer of any size, only ever added to.
+struct BigCount
+{
+	// Base 10^9 digits, least significant first.
+	vector<uint32_t> digits;
+
+	bool zero() const
+	{
+		return digits.empty();
+	}
+
+	void add(const BigCount &other)
+	{
+		if (digits.size() < other.digits.size())
+			digits.resize(other.digits.size(), 0);
+		uint32_t carry = 0;
+		for (size_t i = 0; i < digits.size(); ++i)
+		{
+			uint32_t sum = digits[i] + carry + (i < other.digits.size() ? other.digits[i] : 0);
+			carry = sum >= 1000000000u;
+			digits[i] = carry ? sum - 1000000000u : sum;
+		}
+		if (carry)
+			digits.push_back(carry);
+	}
+
+	string str() const
+	{
+		if (digits.empty())
+			return "0";
+		string text = to_string(digits.back());
+		for (size_t i = digits.size() - 1; i-- > 0;)
+		{
+			string part = to_string(digits[i]);
+			text += string(9 - part.length(), '0') + part;
+		}
+		return text;
+	}
+};
+
+bool count_tilings(string_view floor, string &count)
+{
+	string grid;
+	color_floor(floor, grid);
+	int stride = static_cast<int>(grid.find('\n')) + 1;
+	int rows = static_cast<int>(grid.length()) / stride;
+
+	// Crop to the open cells, lying the box down so its narrow side runs
+	// across the profile.
+	int top = rows, bottom = -1, left = stride, right = -1;
+	for (int r = 0; r < rows; ++r)
+		for (int c = 0; c + 1 < stride; ++c)
+			if (grid[r * stride + c] != '#')
+			{
+				top = min(top, r);
+				bottom = max(bottom, r);
+				left = min(left, c);
+				right = max(right, c);
+			}
+	if (bottom < 0)
+	{
+		count = "1";
+		return true;
+	}
+	int height = bottom - top + 1;
+	int width = right - left + 1;
+	bool transposed = width > height;
+	if (transposed)
+		swap(width, height);
+	if (width > CountWidthLimit)
+		return false;
+
+	auto open = [&](int r, int c)
+	{
+		return transposed ? grid[(top + c) * stride + left + r] != '#' : grid[(top + r) * stride + left + c] != '#';
+	};
+
+	// Cells are placed in row order. Before cell (r, c), bit j of a
+	// profile says whether cell (r, j) for j >= c, or (r + 1, j) for
+	// j < c, is already covered.
+	const size_t states = size_t(1) << width;
+	vector<BigCount> ways(states), next(states);
+	vector<uint32_t> live(1, 0), nextLive;
+	ways[0].digits.assign(1, 1);
+	for (int r = 0; r < height; ++r)
+		for (int c = 0; c < width; ++c)
+		{
+			uint32_t bit = uint32_t(1) << c;
+			nextLive.clear();
+			auto reach = [&](uint32_t profile, const BigCount &from)
+			{
+				if (next[profile].zero())
+					nextLive.push_back(profile);
+				next[profile].add(from);
+			};
+			for (uint32_t profile : live)
+			{
+				const BigCount &from = ways[profile];
+				if (profile & bit)
+					reach(profile & ~bit, from);
+				else if (!open(r, c))
+					reach(profile, from);
+				else
+				{
+					if (r + 1 < height && open(r + 1, c))
+						reach(profile | bit, from);
+					if (c + 1 < width && open(r, c + 1) && !(profile & (bit << 1)))
+						reach(profile | (bit << 1), from);
+				}
+			}
+			for (uint32_t profile : live)
+				ways[profile].digits.clear();
+			swap(ways, next);
+			swap(live, nextLive);
+		}
+
+	count = ways[0].str();
+	return true;
+}
@@ -0,0 +1,26 @@
+#ifndef SOLUTIONS_H
+#define SOLUTIONS_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Floors whose open cells fit a box at most this many cells across, in
+// one direction or the other, can have their tilings counted.
+const int CountWidthLimit = 16;
+
+// Finds one tiling of the floor. Returns false if it has none; otherwise
+// tiled is the floor as color_floor lays it out, every line padded to
+// the same width, with each open cell replaced by the half of its domino
+// it is: '<' and '>' for the left and right half, '^' and 'v' for the top
+// and bottom half. Uses Hopcroft-Karp matching on the cells themselves.
+bool find_tiling(string_view floor, string &tiled);
+
+// Counts the tilings of the floor exactly, in decimal, by a dynamic
+// program over the profile of the narrow side of its open cells.
+// Returns false, leaving count alone, if neither side of the box is
+// within CountWidthLimit.
+bool count_tilings(string_view floor, string &count);
+
+#endif
@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "bits.h"
+#include "rle_floor.h"
+#include "stream_tiling.h"
+
+using namespace std;
+
+// A run of a buffered row, with its parent in a union-find over runs.
+struct BufferedRun
+{
+	Run run;
+	size_t parent;
+	bool sealed;
+};
+
+// Arithmetic modulo the prime 2^61 - 1.
+const uint64_t FieldPrime = (uint64_t(1) << 61) - 1;
+
+static uint64_t field_add(uint64_t a, uint64_t b)
+{
+	uint64_t sum = a + b;
+	return sum >= FieldPrime ? sum - FieldPrime : sum;
+}
+
+static uint64_t field_multiply(uint64_t a, uint64_t b)
+{
+	uint64_t high;
+	uint64_t low = multiply_wide(a, b, high);
+	return field_add(low & FieldPrime, (low >> 61) | (high << 3));
+}
+
+static uint64_t field_inverse(uint64_t a)
+{
+	uint64_t inverse = 1;
+	for (uint64_t e = FieldPrime - 2; e > 0; e >>= 1)
+	{
+		if (e & 1)
+			inverse = field_multiply(inverse, a);
+		a = field_multiply(a, a);
+	}
+	return inverse;
+}
+
+// Column of a row of the matrix, or row of a column, if it is not in use
+// or not eliminated yet.
+const int32_t UnusedSlot = -2;
+const int32_t OpenSlot = -1;
+
+// Decides whether the rows handed to it have a tiling by Gaussian
+// elimination of their adjacency matrix, black cells by red cells, with
+// random weights. The determinant is nonzero only if there is a perfect
+// matching, and if there is one it is zero with probability at most
+// cells / 2^62.
+//
+// The row of a black cell is eliminated as soon as the row below it
+// arrives, and a pivot row is kept only while its red cell can still gain
+// a neighbor, so what is held is the rows of the black cells of the last
+// row and of the pivots on its red cells, and the columns those reach.
+// A column no new row can reach that is left in more columns than the
+// held rows could still take means the matrix is singular, which bounds
+// the columns too.
+class Frontier
+{
+public:
+	Frontier()
+		: rows(0), random(0)
+	{
+	}
+
+	// Takes the open runs of the next row, whose cells all lie within
+	// width columns. Returns false once the floor is known to have no
+	// tiling.
+	bool add_row(const vector<Run> &row, uint32_t width)
+	{
+		if (lastRed.size() < width)
+		{
+			lastRed.resize(width, -1);
+			lastBlack.resize(width, -1);
+		}
+		vector<int32_t> red(lastRed.size(), -1), black(lastRed.size(), -1);
+		for (const Run &run : row)
+			for (uint32_t c = run.begin; c < run.end; ++c)
+			{
+				if ((rows + c) & 1)
+					red[c] = new_column();
+				else
+					black[c] = new_line();
+			}
+
+		// A new red cell joins the row of the black cell above it; a new
+		// black cell has its row reduced by the pivots its columns have.
+		for (const Run &run : row)
+			for (uint32_t c = run.begin; c < run.end; ++c)
+			{
+				if (red[c] >= 0)
+				{
+					if (lastBlack[c] >= 0)
+						lines[lastBlack[c]][red[c]] = weight();
+					continue;
+				}
+				vector<uint64_t> &line = lines[black[c]];
+				if (c > 0 && red[c - 1] >= 0)
+					line[red[c - 1]] = weight();
+				if (c + 1 < red.size() && red[c + 1] >= 0)
+					line[red[c + 1]] = weight();
+				if (lastRed[c] >= 0)
+					line[lastRed[c]] = weight();
+				for (int32_t pivot : pivots)
+				{
+					uint64_t factor = line[lineColumn[pivot]];
+					if (factor != 0)
+						subtract(line, lines[pivot], factor);
+				}
+			}
+
+		// The black cells of the row above have all their neighbors now.
+		for (int32_t line : lastBlack)
+			if (line >= 0 && !eliminate(line))
+				return false;
+		lastRed.swap(red);
+		lastBlack.swap(black);
+		rows++;
+
+		// Only the red cells of the new row can gain neighbors.
+		size_t kept = 0;
+		for (int32_t pivot : pivots)
+		{
+			int32_t column = lineColumn[pivot];
+			if (columnRow[column] + 1 == rows)
+				pivots[kept++] = pivot;
+			else
+			{
+				columnPivot[column] = UnusedSlot;
+				freeColumns.push_back(column);
+				lineColumn[pivot] = UnusedSlot;
+				freeLines.push_back(pivot);
+			}
+		}
+		pivots.resize(kept);
+
+		// Every column no new row reaches must be taken by a row held.
+		size_t held = pivots.size(), closed = 0;
+		for (int32_t line : lastBlack)
+			held += line >= 0;
+		for (size_t column = 0; column < columnRow.size(); ++column)
+		{
+			if (columnPivot[column] != OpenSlot || columnRow[column] + 1 == rows)
+				continue;
+			bool reached = false;
+			for (size_t line = 0; line < lines.size() && !reached; ++line)
+				reached = lineColumn[line] != UnusedSlot && lines[line][column] != 0;
+			if (!reached || ++closed > held)
+				return false;
+		}
+		return true;
+	}
+
+	// Ends the floor; returns whether it has a tiling.
+	bool finish()
+	{
+		return add_row(vector<Run>(), 0);
+	}
+
+private:
+	uint64_t rows;
+	uint64_t random;
+	// Rows of the matrix, each with an entry for every column, and the
+	// column each was eliminated on.
+	vector<vector<uint64_t>> lines;
+	vector<int32_t> lineColumn;
+	vector<int32_t> freeLines;
+	// Row of the red cell of each column, and the row eliminated on it.
+	vector<uint64_t> columnRow;
+	vector<int32_t> columnPivot;
+	vector<int32_t> freeColumns;
+	// Rows eliminated on a red cell of the last row.
+	vector<int32_t> pivots;
+	// Column of each red cell and row of each black cell of the last row,
+	// -1 for the other cells.
+	vector<int32_t> lastRed;
+	vector<int32_t> lastBlack;
+
+	// A nonzero weight, from splitmix64.
+	uint64_t weight()
+	{
+		uint64_t z = (random += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		return z % (FieldPrime - 1) + 1;
+	}
+
+	int32_t new_line()
+	{
+		int32_t line;
+		if (freeLines.empty())
+		{
+			line = static_cast<int32_t>(lines.size());
+			lines.emplace_back(columnRow.size(), 0);
+			lineColumn.push_back(OpenSlot);
+		}
+		else
+		{
+			line = freeLines.back();
+			freeLines.pop_back();
+			fill(lines[line].begin(), lines[line].end(), 0);
+			lineColumn[line] = OpenSlot;
+		}
+		return line;
+	}
+
+	// Columns are only freed once every row is 0 in them.
+	int32_t new_column()
+	{
+		int32_t column;
+		if (freeColumns.empty())
+		{
+			column = static_cast<int32_t>(columnRow.size());
+			columnRow.push_back(0);
+			columnPivot.push_back(OpenSlot);
+			for (vector<uint64_t> &line : lines)
+				line.push_back(0);
+		}
+		else
+		{
+			column = freeColumns.back();
+			freeColumns.pop_back();
+		}
+		columnRow[column] = rows;
+		columnPivot[column] = OpenSlot;
+		return column;
+	}
+
+	// line -= factor * pivot, the pivot being 1 on its column.
+	static void subtract(vector<uint64_t> &line, const vector<uint64_t> &pivot, uint64_t factor)
+	{
+		uint64_t negated = FieldPrime - factor;
+		for (size_t k = 0; k < line.size(); ++k)
+			if (pivot[k] != 0)
+				line[k] = field_add(line[k], field_multiply(negated, pivot[k]));
+	}
+
+	// Eliminates a complete row on one of its columns, preferring columns
+	// no new row reaches, and takes that column out of every other row.
+	// Fails if the row is 0.
+	bool eliminate(int32_t line)
+	{
+		vector<uint64_t> &entries = lines[line];
+		int32_t column = OpenSlot;
+		for (size_t k = 0; k < entries.size(); ++k)
+			if (entries[k] != 0 && columnPivot[k] == OpenSlot && (column == OpenSlot || columnRow[k] < rows))
+				column = static_cast<int32_t>(k);
+		if (column == OpenSlot)
+			return false;
+
+		uint64_t scale = field_inverse(entries[column]);
+		for (uint64_t &entry : entries)
+			entry = field_multiply(entry, scale);
+		for (size_t other = 0; other < lines.size(); ++other)
+		{
+			uint64_t factor = lines[other][column];
+			if (other != size_t(line) && lineColumn[other] != UnusedSlot && factor != 0)
+				subtract(lines[other], entries, factor);
+		}
+		lineColumn[line] = column;
+		columnPivot[column] = line;
+		pivots.push_back(line);
+		return true;
+	}
+};
+
+class StreamTiling::Solver
+{
+public:
+	explicit Solver(size_t window)
+		: window(window), width(0), firstId(0), folded(false)
+	{
+		rowStart.push_back(0);
+	}
+
+	// Takes the open runs of the next row, whose cells all lie within
+	// columns. Returns false once the floor is known to have no tiling.
+	bool add_row(vector<Run> &row, uint32_t columns)
+	{
+		width = max(width, columns);
+		if (folded)
+			return frontier.add_row(row, width);
+		return buffer_row(row);
+	}
+
+	// Ends the floor; returns whether it has a tiling.
+	bool finish()
+	{
+		if (folded)
+			return frontier.finish();
+		unordered_set<size_t> roots;
+		for (size_t id = firstId; id < rowStart.back(); ++id)
+			if (!at(id).sealed)
+				roots.insert(find(id));
+		return solve_sealed(roots);
+	}
+
+private:
+	size_t window;
+	uint32_t width;
+
+	// Buffered rows, oldest first. Run ids count every run ever buffered;
+	// the runs of buffered row r have ids rowStart[r] up to rowStart[r + 1].
+	deque<BufferedRun> runs;
+	deque<size_t> rowStart;
+	size_t firstId;
+
+	// Once folded, the rows read so far are in the frontier, and so are
+	// all rows to come.
+	bool folded;
+	Frontier frontier;
+
+	BufferedRun& at(size_t id)
+	{
+		return runs[id - firstId];
+	}
+
+	size_t find(size_t id)
+	{
+		while (at(id).parent != id)
+		{
+			at(id).parent = at(at(id).parent).parent;
+			id = at(id).parent;
+		}
+		return id;
+	}
+
+	bool buffer_row(const vector<Run> &row)
+	{
+		size_t rows = rowStart.size() - 1;
+		size_t prevBegin = rows > 0 ? rowStart[rows - 1] : rowStart.back();
+		size_t prevEnd = rowStart.back();
+		for (const Run &run : row)
+			runs.push_back(BufferedRun{ run, firstId + runs.size(), false });
+		rowStart.push_back(firstId + runs.size());
+
+		// Join runs of the new row to the runs above that they touch.
+		size_t a = prevBegin, b = prevEnd;
+		while (a < prevEnd && b < rowStart.back())
+		{
+			const Run &x = at(a).run;
+			const Run &y = at(b).run;
+			if (x.begin < y.end && y.begin < x.end)
+			{
+				size_t p = find(a), q = find(b);
+				if (p != q)
+					at(max(p, q)).parent = min(p, q);
+			}
+			if (x.end < y.end)
+				a++;
+			else
+				b++;
+		}
+
+		// Rooms of the row above that the new row doesn't reach are sealed.
+		unordered_set<size_t> reached;
+		for (size_t id = prevEnd; id < rowStart.back(); ++id)
+			reached.insert(find(id));
+		unordered_set<size_t> sealed;
+		for (size_t id = prevBegin; id < prevEnd; ++id)
+			if (!at(id).sealed && reached.count(find(id)) == 0)
+				sealed.insert(find(id));
+		if (!solve_sealed(sealed))
+			return false;
+
+		// Drop the oldest rows once nothing in them is open any more.
+		while (rowStart.size() > 1)
+		{
+			size_t end = rowStart[1];
+			bool done = true;
+			for (size_t id = rowStart[0]; id < end && done; ++id)
+				done = at(id).sealed;
+			if (!done)
+				break;
+			runs.erase(runs.begin(), runs.begin() + (end - firstId));
+			firstId = end;
+			rowStart.pop_front();
+		}
+
+		if (rowStart.size() - 1 <= window)
+			return true;
+		return fold();
+	}
+
+	// Solves every room whose root is in roots, one at a time, and marks
+	// their runs sealed.
+	bool solve_sealed(const unordered_set<size_t> &roots)
+	{
+		if (roots.empty())
+			return true;
+		unordered_map<size_t, size_t> slot;
+		vector<RunFloor> rooms;
+		vector<size_t> topRow;
+		// A root is the first run of its room, so no room starts above the
+		// row of the smallest root.
+		size_t first = *min_element(roots.begin(), roots.end());
+		size_t top = upper_bound(rowStart.begin(), rowStart.end(), first) - rowStart.begin() - 1;
+		for (size_t r = top; r + 1 < rowStart.size(); ++r)
+			for (size_t id = rowStart[r]; id < rowStart[r + 1]; ++id)
+			{
+				if (at(id).sealed)
+					continue;
+				size_t root = find(id);
+				if (roots.count(root) == 0)
+					continue;
+				auto found = slot.emplace(root, rooms.size());
+				if (found.second)
+				{
+					rooms.emplace_back();
+					rooms.back().columns = width;
+					rooms.back().rowStart.assign(1, 0);
+					topRow.push_back(r);
+				}
+				RunFloor &room = rooms[found.first->second];
+				while (room.rows < r - topRow[found.first->second])
+				{
+					room.rowStart.push_back(room.runs.size());
+					room.rows++;
+				}
+				room.runs.push_back(at(id).run);
+				at(id).sealed = true;
+			}
+
+		for (RunFloor &room : rooms)
+		{
+			room.rowStart.push_back(room.runs.size());
+			room.rows++;
+			if (!has_tiling_runs(room))
+				return false;
+		}
+		return true;
+	}
+
+	// Hands every buffered row to the frontier, sealed rooms counting as
+	// walls, and empties the buffer.
+	bool fold()
+	{
+		folded = true;
+		vector<Run> open;
+		for (size_t r = 0; r + 1 < rowStart.size(); ++r)
+		{
+			open.clear();
+			for (size_t id = rowStart[r]; id < rowStart[r + 1]; ++id)
+				if (!at(id).sealed)
+					open.push_back(at(id).run);
+			if (!frontier.add_row(open, width))
+				return false;
+		}
+		firstId = rowStart.back();
+		runs.clear();
+		rowStart.assign(1, firstId);
+		return true;
+	}
+};
+
+StreamTiling::StreamTiling(size_t window)
+	: solver(make_unique<Solver>(window)), tiled(true)
+{
+}
+
+StreamTiling::~StreamTiling()
+{
+}
+
+bool StreamTiling::add_row(string_view line)
+{
+	if (!tiled)
+		return false;
+	vector<Run> row;
+	uint32_t column = 0;
+	for (char ch : line)
+	{
+		if (ch == ' ')
+		{
+			if (!row.empty() && row.back().end == column)
+				row.back().end++;
+			else
+				row.push_back(Run{ column, column + 1 });
+		}
+		if (ch == ' ' || ch == '#')
+			column++;
+	}
+	return tiled = solver->add_row(row, column);
+}
+
+bool StreamTiling::add_row(const uint64_t *words, uint32_t columns)
+{
+	if (!tiled)
+		return false;
+	vector<Run> row;
+	for (uint32_t k = 0; k * 64 < columns; ++k)
+	{
+		uint64_t word = words[k];
+		while (word)
+		{
+			uint32_t begin = k * 64 + lowest_bit(word);
+			// Adding the lowest set bit carries through its run.
+			uint64_t rest = word & (word + (word & (0 - word)));
+			uint32_t end = begin + popcount64(word ^ rest);
+			word = rest;
+			if (!row.empty() && row.back().end == begin)
+				row.back().end = end;
+			else
+				row.push_back(Run{ begin, end });
+		}
+	}
+	return tiled = solver->add_row(row, columns);
+}
+
+bool StreamTiling::finish()
+{
+	return tiled && solver->finish();
+}
+
+bool has_tiling(istream &in, size_t window)
+{
+	StreamTiling floor(window);
+	bool started = false;
+	string line;
+	while (getline(in, line))
+	{
+		if (line.find_first_not_of('\r') == string::npos)
+		{
+			if (started)
+				break;
+			continue;
+		}
+		started = true;
+		floor.add_row(line);
+	}
+	return floor.finish();
+}
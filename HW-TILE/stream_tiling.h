@@ -0,0 +1,65 @@
+#ifndef STREAM_TILING_H
+#define STREAM_TILING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string_view>
+
+using namespace std;
+
+// Rows of open rooms kept before they are folded into the frontier.
+const size_t StreamWindow = 64;
+
+// Decides a floor handed over one row at a time, so a floor of any
+// length can be solved.
+//
+// Rooms are followed as the rows come in, and a room is solved by
+// has_tiling_runs as soon as a row arrives that doesn't touch it. Once
+// more than window rows are kept, they and all later rows go to a
+// frontier instead: Gaussian elimination of the floor's adjacency
+// matrix, with random weights modulo a prime, that holds only the rows
+// and columns of cells next to the last row. So memory is bounded by the
+// width of the floor, at most window rows or a matrix of the order of
+// the open cells of a row squared, and a row costs at most the cube of
+// its open cells.
+//
+// Answers are exact until the floor is folded. After that a floor said
+// to have a tiling has one, but one that has a tiling is said to have
+// none with probability at most its open cells / 2^62.
+class StreamTiling
+{
+public:
+	explicit StreamTiling(size_t window = StreamWindow);
+	~StreamTiling();
+
+	StreamTiling(const StreamTiling&) = delete;
+	StreamTiling& operator=(const StreamTiling&) = delete;
+
+	// Adds the next row, a line of ' ' for open cells and '#' for walls,
+	// columns counted as color_floor counts them. Returns false once the
+	// floor is known to have no tiling; later rows are then ignored.
+	bool add_row(string_view line);
+
+	// Same, for a row of words with bit c set when column c is open, as
+	// packed_floor.h lays rows out.
+	bool add_row(const uint64_t *words, uint32_t columns);
+
+	// Ends the floor and returns whether it has a tiling.
+	bool finish();
+
+private:
+	class Solver;
+	unique_ptr<Solver> solver;
+	bool tiled;
+};
+
+// Returns whether the floor read from the stream has a tiling, handing
+// its lines to a StreamTiling, so with its bounds on memory and its odds
+// of a wrong answer. The floor ends at a blank line or at the end of the
+// stream, and the stream is always left past that point, even when the
+// answer is known early.
+bool has_tiling(istream &in, size_t window = StreamWindow);
+
+#endif
@@ -0,0 +1,173 @@
+#include <chrono>
+#include "thread_pool.h"
+
+using namespace std;
+
+// The pool the current thread works for, and the index of its queue
+// there, or nullptr and -1 if the thread is not a pool worker.
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int currentQueue = -1;
+
+ThreadPool::ThreadPool(unsigned numThreads)
+	: queued(0), nextQueue(0), stopping(false)
+{
+	if (numThreads == 0)
+		numThreads = 1;
+
+	for (unsigned i = 0; i < numThreads; ++i)
+		queues.push_back(make_unique<Queue>());
+	for (unsigned i = 0; i < numThreads; ++i)
+		workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> guard(idleLock);
+		stopping = true;
+	}
+	idle.notify_all();
+	for (thread &t : workers)
+		t.join();
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+	unsigned index;
+	if (currentPool == this)
+		index = static_cast<unsigned>(currentQueue);
+	else
+		index = nextQueue.fetch_add(1, memory_order_relaxed) % queues.size();
+	submit_to(index, move(task));
+}
+
+void ThreadPool::submit_to(unsigned worker, function<void()> task)
+{
+	unsigned index = worker % queues.size();
+	{
+		lock_guard<mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(move(task));
+	}
+	queued.fetch_add(1);
+
+	// Taking the lock orders the notification after a worker's check
+	// of the queue count, so the wakeup cannot be lost.
+	{
+		lock_guard<mutex> guard(idleLock);
+	}
+	idle.notify_one();
+}
+
+bool ThreadPool::take(unsigned self, function<void()> &task)
+{
+	if (queued.load() == 0)
+		return false;
+
+	// Own queue first, newest task first.
+	if (self < queues.size())
+	{
+		Queue &own = *queues[self];
+		lock_guard<mutex> guard(own.lock);
+		if (!own.tasks.empty())
+		{
+			task = move(own.tasks.back());
+			own.tasks.pop_back();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Then steal the oldest task of another queue.
+	unsigned n = static_cast<unsigned>(queues.size());
+	unsigned start = self < n ? self + 1 : nextQueue.load(memory_order_relaxed);
+	for (unsigned k = 0; k < n; ++k)
+	{
+		Queue &other = *queues[(start + k) % n];
+		lock_guard<mutex> guard(other.lock);
+		if (!other.tasks.empty())
+		{
+			task = move(other.tasks.front());
+			other.tasks.pop_front();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::run_one()
+{
+	unsigned self = currentPool == this ? static_cast<unsigned>(currentQueue) : static_cast<unsigned>(queues.size());
+	function<void()> task;
+	if (!take(self, task))
+		return false;
+	task();
+	return true;
+}
+
+unsigned ThreadPool::size() const
+{
+	return static_cast<unsigned>(workers.size());
+}
+
+void ThreadPool::work(unsigned index)
+{
+	currentPool = this;
+	currentQueue = static_cast<int>(index);
+
+	while (true)
+	{
+		function<void()> task;
+		if (take(index, task))
+		{
+			task();
+			continue;
+		}
+
+		unique_lock<mutex> guard(idleLock);
+		idle.wait(guard, [this] { return stopping || queued.load() > 0; });
+		if (stopping && queued.load() == 0)
+			return;
+	}
+}
+
+TaskGroup::TaskGroup()
+	: pending(0)
+{
+}
+
+void TaskGroup::add(size_t n)
+{
+	pending.fetch_add(n);
+}
+
+void TaskGroup::done()
+{
+	// The whole update happens under the lock so that a waiter, which
+	// takes the lock before returning, never outlives a running done().
+	lock_guard<mutex> guard(lock);
+	if (pending.fetch_sub(1) == 1)
+		finished.notify_all();
+}
+
+void TaskGroup::wait(ThreadPool &pool)
+{
+	while (pending.load() > 0)
+	{
+		if (pool.run_one())
+			continue;
+
+		// Nothing left to help with; sleep until the group finishes.
+		// The timeout covers tasks queued by other tasks of the group.
+		unique_lock<mutex> guard(lock);
+		finished.wait_for(guard, chrono::milliseconds(1), [this] { return pending.load() == 0; });
+	}
+
+	lock_guard<mutex> guard(lock);
+}
+
+ThreadPool& default_pool()
+{
+	static ThreadPool pool;
+	return pool;
+}
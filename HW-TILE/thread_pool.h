@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of worker threads with one task queue per worker.
+//
+// A worker runs the newest task of its own queue first and, when that
+// queue is empty, steals the oldest task of another worker. Tasks
+// submitted from inside a task stay on the submitting worker's queue.
+class ThreadPool
+{
+public:
+	// Starts numThreads workers (at least one).
+	explicit ThreadPool(unsigned numThreads = thread::hardware_concurrency());
+
+	// Finishes every queued task, then joins the workers.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Queues a task to be run by some worker.
+	void submit(function<void()> task);
+
+	// Queues a task on the given worker's queue. Other workers only
+	// take it if they run out of work of their own.
+	void submit_to(unsigned worker, function<void()> task);
+
+	// Runs one queued task on the calling thread, if any is available.
+	// Returns whether a task was run.
+	bool run_one();
+
+	// Returns the number of workers.
+	unsigned size() const;
+
+private:
+	struct Queue
+	{
+		mutex lock;
+		deque<function<void()>> tasks;
+	};
+
+	vector<unique_ptr<Queue>> queues;
+	vector<thread> workers;
+
+	// Number of tasks sitting in any queue.
+	atomic<size_t> queued;
+	// Spreads submissions from outside the pool over the queues.
+	atomic<unsigned> nextQueue;
+
+	mutex idleLock;
+	condition_variable idle;
+	bool stopping;
+
+	bool take(unsigned self, function<void()> &task);
+	void work(unsigned index);
+};
+
+// Counts the unfinished tasks of one job so its submitter can wait.
+class TaskGroup
+{
+public:
+	TaskGroup();
+
+	// Records that n more tasks belong to the group.
+	void add(size_t n = 1);
+
+	// Records that one task of the group has finished.
+	void done();
+
+	// Returns once every task of the group has finished,
+	// running queued tasks of the pool in the meantime.
+	void wait(ThreadPool &pool);
+
+private:
+	atomic<size_t> pending;
+	mutex lock;
+	condition_variable finished;
+};
+
+// Returns the pool shared by the library's batch entry points,
+// started on first use with one worker per hardware thread.
+ThreadPool& default_pool();
+
+#endif
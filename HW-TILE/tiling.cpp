@@ -1,16 +1,53 @@
-#ifndef BIPARTGRAPH_H
-#define BIPARTGRAPH_H
-
+#include <chrono>
 #include "tiling.h"
-#include "vertex.h"
+#include "bipart_graph.h"
+#include "small_floor.h"
+#include "grid_kernels.h"
+#include "floor.h"
 
 using namespace std;
 
 
+// Adds the time from its construction until it goes out of scope to one
+// stage of stats, if there are stats.
+class StageTimer
+{
+public:
+	StageTimer(SolveStats *stats, double SolveStats::*stage)
+		: stats(stats), stage(stage)
+	{
+		if (stats)
+			started = chrono::steady_clock::now();
+	}
+
+	~StageTimer()
+	{
+		if (stats)
+			stats->*stage += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+	}
+
+	StageTimer(const StageTimer&) = delete;
+	StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+	SolveStats *stats;
+	double SolveStats::*stage;
+	chrono::steady_clock::time_point started;
+};
+
+size_t graph_bytes(size_t vertices, size_t edges)
+{
+	// A vertex sits in a set; an edge has a node in neighs and one in
+	// weights, each with a bucket.
+	size_t vertexBytes = sizeof(Vertex) + 3 * sizeof(void*);
+	size_t edgeBytes = 3 * sizeof(void*) + 2 * sizeof(void*) + sizeof(pair<Vertex*, int>);
+	return vertices * vertexBytes + edges * edgeBytes;
+}
+
 // Finds a (shortest according to edge length) augmenting path
 // from s to t in a graph with vertex set V.
 // Returns whether there is an augmenting path.
-bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vertex*> &P)
+bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vertex*> &P, SolveStats *stats)
 {
 	// Check that s and t aren't nullptr
 	if (s == nullptr || t == nullptr)
@@ -46,10 +83,16 @@ bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vert
 
 	unordered_map<Vertex*, Vertex*> prev;
 
+	// Counted whether or not anyone asked, which costs less than checking.
+	uint64_t visited = 0;
+	uint64_t scanned = 0;
+
 	while (!Q.empty())
 	{
 		Vertex* cur = Q.front();
 		Q.pop();
+		visited++;
+		scanned += cur->neighs.size();
 
 		for (Vertex* nei : cur->neighs)
 		{
@@ -66,6 +109,12 @@ bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vert
 		}
 	}
 
+	if (stats)
+	{
+		stats->verticesVisited += visited;
+		stats->edgesScanned += scanned;
+	}
+
 	// If BFS never reached t
 	if (R.find(t) == R.end())
 		return false;
@@ -85,7 +134,7 @@ bool augmenting_path(Vertex* s, Vertex* t, unordered_set<Vertex*> V, vector<Vert
 
 // Returns the maximum flow from s to t in a weighted graph with vertex set V.
 // Assumes all edge weights are non-negative.
-int max_flow(Vertex* s, Vertex* t, unordered_set<Vertex*> V)
+int max_flow(Vertex* s, Vertex* t, unordered_set<Vertex*> V, const atomic<bool> *cancel, SolveStats *stats)
 {
 	// If s or t is invalid.
 	if (s == nullptr || t == nullptr)
@@ -136,13 +185,37 @@ int max_flow(Vertex* s, Vertex* t, unordered_set<Vertex*> V)
 			}
 		}
 
+	if (stats)
+	{
+		// The graph, its residual copy, and the copy of the vertex set,
+		// reached set and path map that each search makes.
+		size_t edges = 0, resEdges = 0;
+		for (Vertex* vp : V)
+		{
+			edges += vp->neighs.size();
+			resEdges += C[vp]->neighs.size();
+		}
+		size_t bytes = graph_bytes(V.size(), edges) + graph_bytes(resV.size(), resEdges)
+			+ 3 * V.size() * 3 * sizeof(void*);
+		stats->peakBytes = max<uint64_t>(stats->peakBytes, bytes);
+	}
+
 	// Run Edmonds-Karp
+	bool gaveUp = false;
 	while (true)
 	{
+		// Give up if the solve was cancelled
+		if (cancel && cancel->load(memory_order_relaxed))
+		{
+			gaveUp = true;
+			break;
+		}
 		// Find an augmenting path
 		vector<Vertex*> P;
-		if (!augmenting_path(C[s], C[t], resV, P))
+		if (!augmenting_path(C[s], C[t], resV, P, stats))
 			break;
+		if (stats)
+			stats->augmentations++;
 		// Update residual graph
 		for (int i = 0; i < P.size() - 1; ++i)
 		{
@@ -160,316 +233,314 @@ int max_flow(Vertex* s, Vertex* t, unordered_set<Vertex*> V)
 	for (Vertex* vp : resV)
 		delete vp;
 
-	return flow;
+	return gaveUp ? -1 : flow;
 }
 
 
-class BiPartGraph
+void color_floor(string_view floor, string &colored)
 {
-private:
-
-	//Stores the number of vertices, used to determine the first condition in has_tiling
-	int numVertices;
-	//Stores the set with all the vertices
-	unordered_set<Vertex*> totalCheckers;
-	//Stores the set of black checkers in the bipartite graph
-	unordered_set<Vertex*> blackCheckers;
-	//Stores the set of red checkers in the bipartite graph
-	unordered_set<Vertex*> redCheckers;
-	//Stores all the vertices in the graph with their coordinates
-	unordered_map<Vertex*, pair<int, int>> vertexDictionary;
-
-	//The vertices will be used for max flow and be computed for perfect matching
-	Vertex *source;
-	Vertex *sink;
+	//Lines shorter than the longest one are padded with walls
+	size_t width = 0;
+	size_t rows = 0;
+	size_t begin = 0;
+	while (begin < floor.length())
+	{
+		size_t end = floor.find('\n', begin);
+		if (end == string_view::npos)
+			end = floor.length();
+		width = max(width, end - begin);
+		rows++;
+		begin = end + 1;
+	}
 
+	colored.assign(rows * (width + 1), '#');
 
+	int row = 0;
+	int column = 0;
+	bool firstElmnt = false;
+	int blackParity = 0;
+	size_t out = 0;
 
-	void addNeighbors()
+	//This loops transform the string into another string formated as a checkers board
+	for (size_t i = 0; i < floor.length(); i++)
 	{
-		string dummy = "";
-		for (auto i : blackCheckers)
+		if (floor[i] == '\n')
 		{
-			pair<int, int> up, down, left, right;
-			//Set up coordinates
-			up.first = vertexDictionary.at(i).first - 1;
-			up.second = vertexDictionary.at(i).second;
-			//Set down coordinates
-			down.first = vertexDictionary.at(i).first + 1;
-			down.second = vertexDictionary.at(i).second;
-			//Set left coordinates
-			left.first = vertexDictionary.at(i).first;
-			left.second = vertexDictionary.at(i).second - 1;
-			//Set right coordinates
-			right.first = vertexDictionary.at(i).first;
-			right.second = vertexDictionary.at(i).second + 1;
-
-			//Step 1: Try to search for a neighbor up
-			for (auto k : redCheckers)
+			out += width - column;
+			colored[out++] = '\n';
+			row++;
+			column = 0;
+		}
+		else if (floor[i] == ' ')
+		{
+			//The first open cell is black, and so is every cell of the same parity
+			if (!firstElmnt)
 			{
-				if (vertexDictionary.at(k) == up)
-				{
-					i->neighs.insert(k);
-					i->weights[k] = 1;
-				}
-				else if (vertexDictionary.at(k) == down)
-				{
-					i->neighs.insert(k);
-					i->weights[k] = 1;
-				}
-				else if (vertexDictionary.at(k) == left)
-				{
-					i->neighs.insert(k);
-					i->weights[k] = 1;
-				}
-				else if (vertexDictionary.at(k) == right)
-				{
-					i->neighs.insert(k);
-					i->weights[k] = 1;
-				}
+				blackParity = (row + column) % 2;
+				firstElmnt = true;
 			}
+			if ((row + column) % 2 == blackParity)
+				colored[out++] = 'b';
+			else
+				colored[out++] = 'r';
+			column++;
+		}
+		else if (floor[i] == '#')
+		{
+			out++;
+			column++;
 		}
 	}
+	if (!colored.empty())
+		colored[colored.length() - 1] = '\n';
+}
+
+Reduction reduce_floor(string &colored)
+{
+	size_t stride = colored.find('\n') + 1;
+	size_t size = colored.length();
 
-	//This function connects the source to all the blac checkers
-	void setSource()
+	auto isOpen = [&](size_t at)
 	{
-		for (auto i : blackCheckers)
-		{
-			source->neighs.insert(i);
-			//Sets the max flow to 1
-			source->weights[i] = 1;
-		}
-		totalCheckers.insert(source);
+		return at < size && (colored[at] == 'b' || colored[at] == 'r');
+	};
+
+	//Returns the number of open neighbors of the cell, and one of them
+	auto degree = [&](size_t at, size_t &neighbor)
+	{
+		int count = 0;
+		const size_t around[4] = { at - stride, at + stride, at - 1, at + 1 };
+		for (size_t next : around)
+			if (isOpen(next))
+			{
+				neighbor = next;
+				count++;
+			}
+		return count;
+	};
+
+	//Every cell with at most one open neighbor decides its own domino
+	vector<size_t> forced;
+	bool anyOpen = false;
+	for (size_t at = 0; at < size; ++at)
+	{
+		size_t neighbor;
+		if (!isOpen(at))
+			continue;
+		anyOpen = true;
+		if (degree(at, neighbor) <= 1)
+			forced.push_back(at);
 	}
 
-	//This function connects all the red checkers to the sink
-	void setSink()
+	while (!forced.empty())
 	{
-		for (auto i : redCheckers)
+		size_t at = forced.back();
+		forced.pop_back();
+		if (!isOpen(at))
+			continue;
+
+		size_t partner = 0;
+		if (degree(at, partner) == 0)
+			return Reduction::NoTiling;
+
+		//Place the domino, then revisit the cells that lost a neighbor
+		colored[at] = '#';
+		colored[partner] = '#';
+		const size_t around[4] = { partner - stride, partner + stride, partner - 1, partner + 1 };
+		for (size_t next : around)
 		{
-			i->neighs.insert(sink);
-			//Sets the max flow to 1
-			i->weights[sink] = 1;
+			size_t neighbor;
+			if (isOpen(next) && degree(next, neighbor) <= 1)
+				forced.push_back(next);
 		}
-		totalCheckers.insert(sink);
 	}
 
+	if (!anyOpen)
+		return Reduction::Tiled;
+	for (size_t at = 0; at < size; ++at)
+		if (isOpen(at))
+			return Reduction::Undecided;
+	return Reduction::Tiled;
+}
+
+bool match_floor(const string &colored, const atomic<bool> *cancel, SolveStats *stats, bool *cancelled)
+{
+	int flow, numB;
 
-public:
+	BiPartGraph CheckerBoard;
 
-	//Default constructor
-	BiPartGraph()
 	{
-		source = new Vertex();
-		sink = new Vertex();
-		numVertices = 0;
+		StageTimer timer(stats, &SolveStats::buildSeconds);
+		CheckerBoard.constructGraph(colored);
 	}
 
-	//This function returns false if the two sets do not have the same number of elements
-	bool isValid()
+	if (CheckerBoard.isValid() == false)
 	{
-		if (blackCheckers.size() == redCheckers.size())
-			return true;
-		else
-			return false;
+		return false;
 	}
 
-	void constructGraph(string floor)
+	//max flow
 	{
-		int row = 0;
-		int column = 0;
-
-		for (int i = 0; i < floor.length(); i++)
-		{
-			if (floor[i] == '#')
-				column++;
-			else if (floor[i] == '\n')
-			{
-				row++;
-				column = 0;
-			}
-			else if (floor[i] == 'b')
-			{
-				Vertex * baby = new Vertex();
-				pair<int, int> bPair;
-				bPair.first = row;
-				bPair.second = column;
-				blackCheckers.insert(baby);
-				totalCheckers.insert(baby);
-				vertexDictionary[baby] = bPair;
-				column++;
-			}
-			else
-			{
-				Vertex * baby = new Vertex();
-				pair<int, int> bPair;
-				bPair.first = row;
-				bPair.second = column;
-				redCheckers.insert(baby);
-				totalCheckers.insert(baby);
-				vertexDictionary[baby] = bPair;
-				column++;
-			}
-		}
-		addNeighbors();
-		setSource();
-		setSink();
+		StageTimer timer(stats, &SolveStats::matchSeconds);
+		flow = CheckerBoard.getFlow(cancel, stats);
 	}
-	Vertex* GetSource()
+	numB = CheckerBoard.getB();
+	if (cancelled)
+		*cancelled = flow < 0;
+
+	if (flow == numB)
+		return true;
+	else
+		return false;
+}
+
+bool TilingContext::solve(string_view floor, const atomic<bool> *cancel, SolveStats *stats)
+{
+	gaveUp = false;
+
+	//Small floors never need a graph
+	SmallFloor small;
+	bool isSmall;
 	{
-		return source;
+		StageTimer timer(stats, &SolveStats::parseSeconds);
+		isSmall = load_small_floor(floor, small);
 	}
-	Vertex* GetSink()
+	if (isSmall)
 	{
-		return sink;
+		StageTimer timer(stats, &SolveStats::matchSeconds);
+		return small_has_tiling(small);
 	}
 
-	int getFlow()
+	//Floors of a common width have their own kernels
+	Reduction reduced;
+	bool fixed;
 	{
-		return max_flow(source, sink, totalCheckers);
+		StageTimer timer(stats, &SolveStats::kernelSeconds);
+		fixed = solve_fixed_width(floor, rowBits, modFloor, reduced);
 	}
-
-	int getB()
+	if (fixed)
 	{
-		int counter = 0;
-		for (auto i : blackCheckers)
-		{
-			counter++;
-		}
-		return counter;
+		if (reduced != Reduction::Undecided)
+			return reduced == Reduction::Tiled;
 	}
-
-	///Helper method to display variables
-	void displayFlow()
+	else
 	{
-		int counter = 1;
+		StageTimer timer(stats, &SolveStats::colorSeconds);
+		color_floor(floor, modFloor);
+	}
 
-		cout << "Source" << endl;
-		cout << "Neighbors: ";
-		for (auto x : source->neighs)
-			cout << vertexDictionary[x].first << "," << vertexDictionary[x].second << " :: ";
-		cout << endl;
+	return solve_colored(cancel, stats);
+}
 
-		for (auto i : vertexDictionary)
-		{
-			cout << counter << ": " << i.second.first << "," << i.second.second << endl;
-			cout << "Neighbors: ";
-			for (auto k : i.first->neighs)
-			{
-				cout << vertexDictionary[k].first << "," << vertexDictionary[k].second << " :: ";
-			}
-			counter++;
-			cout << endl;
-		}
+bool TilingContext::solve_rows(const uint64_t *words, size_t rows, int columns, const atomic<bool> *cancel,
+	SolveStats *stats)
+{
+	gaveUp = false;
+	Reduction reduced;
+	{
+		StageTimer timer(stats, &SolveStats::kernelSeconds);
+		rowBits.assign(words, words + rows);
+		reduced = solve_row_words(rowBits, columns, modFloor);
+	}
+	if (reduced != Reduction::Undecided)
+		return reduced == Reduction::Tiled;
+	return solve_colored(cancel, stats);
+}
 
-		cout << "Sink" << endl;
-		cout << "Neighbors: ";
-		for (auto y : sink->neighs)
-			cout << vertexDictionary[y].first << "," << vertexDictionary[y].second << " :: ";
-		cout << endl;
+bool TilingContext::solve_colored(const atomic<bool> *cancel, SolveStats *stats)
+{
+	if (cancel && cancel->load(memory_order_relaxed))
+	{
+		gaveUp = true;
+		return false;
+	}
+	if (stats)
+		stats->peakBytes = max<uint64_t>(stats->peakBytes, buffer_bytes());
 
-		system("pause");
+	Reduction reduced;
+	{
+		StageTimer timer(stats, &SolveStats::kernelSeconds);
+		reduced = reduce_floor(modFloor);
 	}
-};
+	if (reduced != Reduction::Undecided)
+		return reduced == Reduction::Tiled;
+	return match_rooms(modFloor, cancel, stats);
+}
 
-bool has_tiling(string floor)
+bool TilingContext::match_rooms(string &colored, const atomic<bool> *cancel, SolveStats *stats)
 {
-	string modFloor = "";
-	int row = 0;
-	int column = 0;
-	int flow, numB;
-	bool firstElmnt = false;
-	bool startsEven;
+	gaveUp = false;
 
-	//This loops transform the string into another string formated as a checkers board
-	for (int i = 0; i < floor.length(); i++)
+	//What the reduction leaves often falls apart into separate rooms,
+	//and the small ones need no graph
+	vector<string> rooms;
 	{
-		if (floor[i] == '#')
+		StageTimer timer(stats, &SolveStats::kernelSeconds);
+		for (char &cell : colored)
+			if (cell == 'b' || cell == 'r')
+				cell = ' ';
+		rooms = split_components(colored);
+	}
+	size_t roomBytes = 0;
+	for (const string &room : rooms)
+		roomBytes += room.capacity();
+
+	SmallFloor small;
+	for (const string &room : rooms)
+	{
+		if (cancel && cancel->load(memory_order_relaxed))
 		{
-			modFloor += floor[i];
-			column++;
+			gaveUp = true;
+			return false;
 		}
-		else if (floor[i] == '\n')
+		bool isSmall;
 		{
-			row++;
-			column = 0;
-			modFloor += floor[i];
+			StageTimer timer(stats, &SolveStats::parseSeconds);
+			isSmall = load_small_floor(room, small);
 		}
-		else if (floor[i] == ' ')
+		if (isSmall)
 		{
-			if (!firstElmnt)
-			{
-				if (column % 2 == 0)
-					startsEven = true;
-				else
-					startsEven = false;
-				modFloor += 'b';
-				firstElmnt = true;
-			}
-			else if (startsEven)
-			{
-				if (row % 2 != 0)
-				{
-					if (column % 2 == 0)
-						modFloor += 'b';
-					else
-						modFloor += 'r';
-				}
-				else
-				{
-					if (column % 2 != 0)
-						modFloor += 'b';
-					else
-						modFloor += 'r';
-				}
-			}
-			else
-			{
-				if (row % 2 != 0)
-				{
-					if (column % 2 == 0)
-						modFloor += 'r';
-					else
-						modFloor += 'b';
-				}
-				else
-				{
-					if (column % 2 != 0)
-						modFloor += 'r';
-					else
-						modFloor += 'b';
-				}
-			}
-			column++;
+			StageTimer timer(stats, &SolveStats::matchSeconds);
+			if (!small_has_tiling(small))
+				return false;
+			continue;
+		}
+		{
+			StageTimer timer(stats, &SolveStats::colorSeconds);
+			color_floor(room, roomFloor);
 		}
-	}
-
-	BiPartGraph CheckerBoard;
-
-	CheckerBoard.constructGraph(modFloor);
 
-	if (CheckerBoard.isValid() == false)
-	{
-		return false;
+		//match_floor raises peakBytes to its graphs alone; the buffers
+		//and rooms are held on top of them
+		uint64_t peak = 0;
+		if (stats)
+			swap(peak, stats->peakBytes);
+		bool matched = match_floor(roomFloor, cancel, stats, &gaveUp);
+		if (stats)
+			stats->peakBytes = max<uint64_t>(peak, stats->peakBytes + buffer_bytes() + roomBytes);
+		if (!matched)
+			return false;
 	}
+	return true;
+}
 
-	Vertex *s = CheckerBoard.GetSource();
-	Vertex *t = CheckerBoard.GetSink();
-
-	//max flow
-	flow = CheckerBoard.getFlow();
-	numB = CheckerBoard.getB();
+size_t TilingContext::buffer_bytes() const
+{
+	return modFloor.capacity() + roomFloor.capacity() + rowBits.capacity() * sizeof(uint64_t);
+}
 
-	//augmented path
-	//cout << modFloor << endl;
-	//CheckerBoard.displayFlow();
-	
-	if (flow == numB)
-		return true;
-	else
-		return false;
+TilingContext& local_context()
+{
+	thread_local TilingContext context;
+	return context;
 }
 
+bool has_tiling(string_view floor)
+{
+	return local_context().solve(floor);
+}
 
-#endif // !BIPARTGRAPH_H
\ No newline at end of file
+bool has_tiling(string_view floor, SolveStats &stats)
+{
+	return local_context().solve(floor, nullptr, &stats);
+}
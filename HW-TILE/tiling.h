@@ -1,7 +1,8 @@
-
 #ifndef TILING_H
 #define TILING_H
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <utility>
@@ -10,15 +11,138 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
 // Returns whether the floor represented by the parameter string has a tiling.
+// The floor is read in place, without copying it.
 //
-// If the parameter string does not represent a valid floor, 
-// then the function has undefined behavior.        
-bool has_tiling(string floor);
+// If the parameter string does not represent a valid floor,
+// then the function has undefined behavior.
+bool has_tiling(string_view floor);
 
-#endif
+// Where the time and work of solves went, for finding out why a floor is
+// slow. Solves given one add to it, so one object can total many solves;
+// solves given none pay only a null check per stage.
+struct SolveStats
+{
+	// Seconds in each stage. Parsing is load_small_floor; coloring is
+	// color_floor; building is BiPartGraph::constructGraph, addNeighbors
+	// included; kernelization is reduce_floor and split_components, and
+	// also the fixed-width kernels, which parse, color and reduce in one
+	// pass; matching is small_has_tiling and max_flow.
+	double parseSeconds = 0;
+	double colorSeconds = 0;
+	double buildSeconds = 0;
+	double kernelSeconds = 0;
+	double matchSeconds = 0;
+
+	// Augmenting paths found by max_flow.
+	uint64_t augmentations = 0;
+	// Vertices taken off the queue by augmenting_path.
+	uint64_t verticesVisited = 0;
+	// Edges looked at by augmenting_path.
+	uint64_t edgesScanned = 0;
+	// Most bytes held at once by the solver's buffers and flow graphs,
+	// estimated from their element counts rather than by tracking
+	// allocations. The largest over the solves, not their sum.
+	uint64_t peakBytes = 0;
+};
+
+// Same as has_tiling, adding what the solve did to stats.
+bool has_tiling(string_view floor, SolveStats &stats);
+
+// Scratch state for deciding floors, kept between calls so that a
+// thread solving many floors reuses its buffers instead of
+// reallocating them for every floor.
+//
+// A context must not be used by two threads at once.
+class TilingContext
+{
+public:
+	// Returns whether the floor has a tiling, reading it in place.
+	// Floors whose open cells fit in a small box are solved by
+	// small_has_tiling, and floors of a width with its own kernels start
+	// with solve_fixed_width. The rest go through color_floor and
+	// reduce_floor; any rooms left after that are matched one by one,
+	// small ones by small_has_tiling and the rest by match_floor.
+	//
+	// If cancel is given, it is checked between the stages, between rooms
+	// and before each augmenting path of match_floor, and once it is set
+	// solve gives up and returns false. If
+	// stats is given, the solve's timings and counters are added to it.
+	bool solve(string_view floor, const atomic<bool> *cancel = nullptr, SolveStats *stats = nullptr);
+
+	// Same as solve, for a floor given as one word of open cells per row,
+	// bit c being column c, with at most 64 columns and every bit past
+	// the last column clear. Such floors skip parsing and go straight to
+	// the fixed-width kernels.
+	bool solve_rows(const uint64_t *words, size_t rows, int columns, const atomic<bool> *cancel = nullptr,
+		SolveStats *stats = nullptr);
+
+	// Finishes a colored floor that reduce_floor left Undecided, as solve
+	// does: splits it into rooms, which it then matches one by one. The
+	// floor is used as scratch space.
+	bool match_rooms(string &colored, const atomic<bool> *cancel = nullptr, SolveStats *stats = nullptr);
+
+	// Whether the last solve, solve_rows or match_rooms gave up on its
+	// cancel flag, in which case its false is no answer. A solve that
+	// finished before the flag was set has decided its floor.
+	bool cancelled() const { return gaveUp; }
 
+private:
+	// Reduces and matches the colored floor held in modFloor.
+	bool solve_colored(const atomic<bool> *cancel, SolveStats *stats);
 
+	// Bytes held by the buffers below.
+	size_t buffer_bytes() const;
+
+	// The colored floor being solved.
+	string modFloor;
+	// One room of it, colored for match_floor.
+	string roomFloor;
+	// One word of open cells per row, for solve_fixed_width.
+	vector<uint64_t> rowBits;
+	// Set when the last solve gave up on its cancel flag.
+	bool gaveUp = false;
+};
+
+// The stages of TilingContext::solve, exposed so that they can be run
+// by different threads.
+
+// Writes the floor into colored with every open cell replaced by 'b' or
+// 'r' according to its checkerboard color. Lines are padded with walls
+// to the width of the longest one, and every line ends in a newline.
+void color_floor(string_view floor, string &colored);
+
+// Outcome of reduce_floor.
+enum class Reduction
+{
+	// Open cells remain; the floor still needs matching.
+	Undecided,
+	// Some open cell can no longer be covered.
+	NoTiling,
+	// Every open cell was covered.
+	Tiled
+};
+
+// Places every forced domino of a colored floor: while an open cell has a
+// single open neighbor, the two are covered together and become walls.
+// What remains is the part of the floor where some choice is left.
+Reduction reduce_floor(string &colored);
+
+// Returns whether a colored floor has a perfect matching between its
+// black and red cells, computed as a maximum flow. If cancel is given,
+// it is checked before each augmenting path, and once it is set
+// match_floor gives up and returns false. If stats is given, the graph
+// build and the flow are added to it, and its peakBytes is raised to the
+// size of the graphs. If cancelled is given, it is set to whether
+// match_floor gave up.
+bool match_floor(const string &colored, const atomic<bool> *cancel = nullptr, SolveStats *stats = nullptr,
+	bool *cancelled = nullptr);
+
+// Returns the calling thread's solver context.
+TilingContext& local_context();
+
+#endif
@@ -0,0 +1,488 @@
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "solutions.h"
+#include "tiling.h"
+#include "tiling_server.h"
+
+using namespace std;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Number of recent requests the latency percentiles are taken over.
+static const size_t LatencySamples = 4096;
+
+static void fail(const char *what, const string &path)
+{
+	cerr << what << " " << path << ": " << strerror(errno) << endl;
+	abort();
+}
+
+static sockaddr_un socket_address(const string &path)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+	{
+		cerr << "Socket path too long: " << path << endl;
+		abort();
+	}
+	memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	return address;
+}
+
+static void set_nonblocking(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void append_response(string &out, uint32_t id, Status status, string_view payload)
+{
+	ResponseHeader header = { id, status, static_cast<uint32_t>(payload.size()) };
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.append(payload.data(), payload.size());
+}
+
+TilingServer::TilingServer(const ServerOptions &options)
+	: options(options), pool(nullptr), stopping(false), solverStopping(false),
+	latencies(LatencySamples), latencyCount(0), received(0), answered(0)
+{
+	if (options.threads > 0)
+	{
+		ownPool = make_unique<ThreadPool>(options.threads);
+		pool = ownPool.get();
+	}
+	else
+		pool = &default_pool();
+
+	int wake[2];
+	if (pipe(wake) != 0)
+		fail("Cannot create pipe for", options.socketPath);
+	wakeRead = wake[0];
+	wakeWrite = wake[1];
+	set_nonblocking(wakeRead);
+	set_nonblocking(wakeWrite);
+
+	listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0)
+		fail("Cannot create socket", options.socketPath);
+	sockaddr_un address = socket_address(options.socketPath);
+	unlink(options.socketPath.c_str());
+	if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		fail("Cannot bind", options.socketPath);
+	if (listen(listener, SOMAXCONN) != 0)
+		fail("Cannot listen on", options.socketPath);
+	set_nonblocking(listener);
+}
+
+TilingServer::~TilingServer()
+{
+	close(listener);
+	close(wakeRead);
+	close(wakeWrite);
+	unlink(options.socketPath.c_str());
+}
+
+void TilingServer::stop()
+{
+	stopping.store(true);
+	char byte = 0;
+	(void)!write(wakeWrite, &byte, 1);
+}
+
+void TilingServer::run()
+{
+	thread solver(&TilingServer::dispatch_jobs, this);
+
+	map<uint64_t, Connection> connections;
+	uint64_t nextSerial = 0;
+	vector<pollfd> watched;
+	vector<uint64_t> serials;
+	vector<Job> jobs;
+	vector<Reply> replies;
+
+	while (!stopping.load())
+	{
+		watched.clear();
+		serials.clear();
+		watched.push_back({ listener, POLLIN, 0 });
+		watched.push_back({ wakeRead, POLLIN, 0 });
+		for (auto &entry : connections)
+		{
+			short events = entry.second.closing ? 0 : POLLIN;
+			if (!entry.second.out.empty())
+				events |= POLLOUT;
+			watched.push_back({ entry.second.socket, events, 0 });
+			serials.push_back(entry.first);
+		}
+		if (poll(watched.data(), watched.size(), -1) < 0 && errno != EINTR)
+			break;
+
+		// Answers from the solver go to their connections' buffers.
+		if (watched[1].revents & POLLIN)
+		{
+			char drain[256];
+			while (read(wakeRead, drain, sizeof(drain)) > 0)
+				;
+			{
+				lock_guard<mutex> guard(lock);
+				replies.swap(outbox);
+			}
+			for (const Reply &r : replies)
+			{
+				auto found = connections.find(r.connection);
+				if (found != connections.end())
+				{
+					append_response(found->second.out, r.id, r.status, r.payload);
+					found->second.unanswered--;
+				}
+			}
+			replies.clear();
+		}
+
+		if (watched[0].revents & POLLIN)
+		{
+			int client;
+			while ((client = accept(listener, nullptr, nullptr)) >= 0)
+			{
+				set_nonblocking(client);
+				connections[nextSerial++] = Connection{ client, string(), string(), 0, false };
+			}
+		}
+
+		for (size_t k = 0; k < serials.size(); ++k)
+		{
+			auto found = connections.find(serials[k]);
+			Connection &connection = found->second;
+			short events = watched[k + 2].revents;
+			// A hang-up once the client has shut down its side means it is
+			// gone altogether, and its answers can't be sent.
+			bool broken = (events & (POLLERR | POLLNVAL)) != 0 || (connection.closing && (events & POLLHUP));
+
+			if (!broken && !connection.closing && (events & (POLLIN | POLLHUP)))
+				read_requests(serials[k], connection, jobs, broken);
+
+			// Write whatever is pending, including answers just added.
+			while (!broken && !connection.out.empty())
+			{
+				ssize_t sent = ::send(connection.socket, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+				if (sent < 0)
+				{
+					broken = errno != EAGAIN && errno != EWOULDBLOCK;
+					break;
+				}
+				connection.out.erase(0, static_cast<size_t>(sent));
+			}
+
+			if (broken || (connection.closing && connection.unanswered == 0 && connection.out.empty()))
+			{
+				close(connection.socket);
+				connections.erase(found);
+			}
+		}
+
+		if (!jobs.empty())
+		{
+			received.fetch_add(jobs.size());
+			lock_guard<mutex> guard(lock);
+			for (Job &job : jobs)
+				inbox.push_back(move(job));
+			jobs.clear();
+			work.notify_one();
+		}
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		solverStopping = true;
+	}
+	work.notify_one();
+	solver.join();
+	for (auto &entry : connections)
+		close(entry.second.socket);
+}
+
+void TilingServer::read_requests(uint64_t serial, Connection &connection, vector<Job> &jobs, bool &broken)
+{
+	char block[64 * 1024];
+	for (;;)
+	{
+		ssize_t got = recv(connection.socket, block, sizeof(block), 0);
+		if (got > 0)
+		{
+			connection.in.append(block, static_cast<size_t>(got));
+			continue;
+		}
+		// The client shutting down its side still gets the answers to
+		// what it sent.
+		if (got == 0)
+			connection.closing = true;
+		else if (errno != EAGAIN && errno != EWOULDBLOCK)
+			broken = true;
+		break;
+	}
+
+	size_t used = 0;
+	RequestHeader header;
+	while (connection.in.size() - used >= sizeof(header))
+	{
+		memcpy(&header, connection.in.data() + used, sizeof(header));
+		if (header.length > MaxRequestBytes)
+		{
+			broken = true;
+			return;
+		}
+		if (connection.in.size() - used - sizeof(header) < header.length)
+			break;
+		const char *payload = connection.in.data() + used + sizeof(header);
+		used += sizeof(header) + header.length;
+
+		switch (header.op)
+		{
+		case Op::HasTiling:
+		case Op::Tiling:
+		case Op::Count:
+			jobs.push_back(Job{ serial, header.id, header.op, string(payload, header.length), chrono::steady_clock::now() });
+			connection.unanswered++;
+			break;
+		case Op::Stats:
+			append_response(connection.out, header.id, Status::Ok, stats_text());
+			break;
+		default:
+			append_response(connection.out, header.id, Status::BadRequest, string_view());
+			break;
+		}
+	}
+	connection.in.erase(0, used);
+}
+
+void TilingServer::dispatch_jobs()
+{
+	vector<Job> arrived;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			work.wait(guard, [this] { return solverStopping || !inbox.empty(); });
+			if (inbox.empty())
+				break;
+			arrived.swap(inbox);
+		}
+
+		// Each job is a task of its own, so a slow floor holds up only its
+		// own answer, and jobs arriving meanwhile start on idle workers.
+		inFlight.add(arrived.size());
+		for (Job &job : arrived)
+			pool->submit([this, job = move(job)]
+			{
+				solve_job(job);
+				inFlight.done();
+			});
+		arrived.clear();
+	}
+	inFlight.wait(*pool);
+}
+
+void TilingServer::solve_job(const Job &job)
+{
+	string text;
+	switch (job.op)
+	{
+	case Op::Tiling:
+		if (find_tiling(job.floor, text))
+			reply(job, Status::Tiled, move(text));
+		else
+			reply(job, Status::NoTiling);
+		break;
+	case Op::Count:
+		if (count_tilings(job.floor, text))
+			reply(job, Status::Ok, move(text));
+		else
+			reply(job, Status::BadRequest);
+		break;
+	default:
+		{
+			bool answer = options.cache ? options.cache->has_tiling(job.floor) : has_tiling(job.floor);
+			reply(job, answer ? Status::Tiled : Status::NoTiling);
+		}
+		break;
+	}
+}
+
+void TilingServer::reply(const Job &job, Status status, string payload)
+{
+	auto waited = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - job.received);
+	{
+		lock_guard<mutex> guard(lock);
+		outbox.push_back(Reply{ job.connection, job.id, status, move(payload) });
+		latencies[latencyCount++ % LatencySamples] = static_cast<uint32_t>(min<long long>(waited.count(), UINT32_MAX));
+	}
+	answered.fetch_add(1);
+	char byte = 0;
+	(void)!write(wakeWrite, &byte, 1);
+}
+
+string TilingServer::stats_text()
+{
+	vector<uint32_t> recent;
+	{
+		lock_guard<mutex> guard(lock);
+		recent.assign(latencies.begin(), latencies.begin() + min(latencyCount, LatencySamples));
+	}
+	sort(recent.begin(), recent.end());
+	auto percentile = [&recent](double p) -> uint32_t
+	{
+		return recent.empty() ? 0 : recent[static_cast<size_t>(p * (recent.size() - 1))];
+	};
+
+	uint64_t in = received.load();
+	uint64_t out = answered.load();
+	ostringstream text;
+	text << "requests " << in << "\n";
+	text << "queued " << in - min(in, out) << "\n";
+	text << "latency_p50_us " << percentile(0.50) << "\n";
+	text << "latency_p90_us " << percentile(0.90) << "\n";
+	text << "latency_p99_us " << percentile(0.99) << "\n";
+	if (options.cache)
+	{
+		ResultCache::Stats s = options.cache->stats();
+		uint64_t lookups = s.hits + s.misses + s.waits;
+		text << "cache_hits " << s.hits << "\n";
+		text << "cache_misses " << s.misses << "\n";
+		text << "cache_hit_rate " << (lookups ? double(s.hits + s.waits) / lookups : 0.0) << "\n";
+	}
+	return text.str();
+}
+
+TilingClient::TilingClient(const string &socketPath)
+	: nextId(0)
+{
+	socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address = socket_address(socketPath);
+	if (socket < 0 || connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+		fail("Cannot connect to", socketPath);
+}
+
+TilingClient::~TilingClient()
+{
+	close(socket);
+}
+
+// Sends or receives exactly size bytes, unless the other end goes away.
+static bool send_all(int socket, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t sent = ::send(socket, data, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+		data += sent;
+		size -= static_cast<size_t>(sent);
+	}
+	return true;
+}
+
+static bool receive_all(int socket, char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t got = recv(socket, data, size, 0);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return false;
+		data += got;
+		size -= static_cast<size_t>(got);
+	}
+	return true;
+}
+
+uint32_t TilingClient::send(Op op, string_view payload)
+{
+	RequestHeader header = { nextId++, op, static_cast<uint32_t>(payload.size()) };
+	send_all(socket, reinterpret_cast<const char*>(&header), sizeof(header));
+	send_all(socket, payload.data(), payload.size());
+	return header.id;
+}
+
+bool TilingClient::receive(uint32_t &id, Status &status, string &payload)
+{
+	ResponseHeader header;
+	if (!receive_all(socket, reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+	payload.resize(header.length);
+	if (!receive_all(socket, &payload[0], header.length))
+		return false;
+	id = header.id;
+	status = header.status;
+	return true;
+}
+
+void TilingClient::finish_sending()
+{
+	shutdown(socket, SHUT_WR);
+}
+
+bool TilingClient::has_tiling(string_view floor)
+{
+	send(Op::HasTiling, floor);
+	uint32_t id;
+	Status status = Status::BadRequest;
+	string payload;
+	receive(id, status, payload);
+	return status == Status::Tiled;
+}
+
+string TilingClient::stats()
+{
+	send(Op::Stats);
+	uint32_t id;
+	Status status;
+	string payload;
+	if (!receive(id, status, payload))
+		return string();
+	return payload;
+}
+
+bool TilingClient::tiling(string_view floor, string &tiled)
+{
+	send(Op::Tiling, floor);
+	uint32_t id;
+	Status status = Status::BadRequest;
+	if (!receive(id, status, tiled) || status != Status::Tiled)
+	{
+		tiled.clear();
+		return false;
+	}
+	return true;
+}
+
+bool TilingClient::count(string_view floor, string &count)
+{
+	send(Op::Count, floor);
+	uint32_t id;
+	Status status = Status::BadRequest;
+	if (!receive(id, status, count) || status != Status::Ok)
+	{
+		count.clear();
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef TILING_SERVER_H
+#define TILING_SERVER_H
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "result_cache.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Wire format of the tiling server, in host byte order since both ends
+// share a host. A request is a RequestHeader followed by length bytes of
+// payload; a response is a ResponseHeader followed by its payload. Each
+// response carries the id of its request. A client may send any number
+// of requests before reading, and responses come back in completion
+// order, not request order.
+enum class Op : uint32_t
+{
+	// Payload is a floor; answered with NoTiling or Tiled.
+	HasTiling = 1,
+	// No payload; answered with Ok and a text of "name value" lines.
+	Stats = 2,
+	// Payload is a floor; answered with Tiled and the floor tiled as
+	// find_tiling() draws it, or with NoTiling and no payload.
+	Tiling = 3,
+	// Payload is a floor; answered with Ok and its number of tilings in
+	// decimal, or with BadRequest if count_tilings() can't count it.
+	Count = 4,
+};
+
+enum class Status : uint32_t
+{
+	NoTiling = 0,
+	Tiled = 1,
+	Ok = 2,
+	BadRequest = 3,
+};
+
+struct RequestHeader
+{
+	uint32_t id;
+	Op op;
+	uint32_t length;
+};
+
+struct ResponseHeader
+{
+	uint32_t id;
+	Status status;
+	uint32_t length;
+};
+
+// Requests with a longer payload make the server drop the connection.
+const uint32_t MaxRequestBytes = 1u << 30;
+
+struct ServerOptions
+{
+	// Path of the Unix domain socket to listen on, replaced if present.
+	string socketPath;
+	// Workers of the server's own pool; 0 uses default_pool().
+	unsigned threads = 0;
+	// If set, floors are answered through this cache, and its hit rate
+	// is part of the stats.
+	ResultCache *cache = nullptr;
+};
+
+// Long-lived server answering has_tiling, find_tiling and count_tilings
+// over a Unix domain socket.
+//
+// One thread does all socket I/O with poll(). Requests read in one pass
+// are handed over with a single wake-up of the dispatching thread, which
+// submits each of them to the pool as a task of its own; a request never
+// waits for the others of its burst to be answered.
+class TilingServer
+{
+public:
+	// Listens on options.socketPath. Aborts if that fails.
+	explicit TilingServer(const ServerOptions &options);
+	~TilingServer();
+
+	TilingServer(const TilingServer&) = delete;
+	TilingServer& operator=(const TilingServer&) = delete;
+
+	// Serves clients until stop() is called.
+	void run();
+
+	// Makes run() return. Safe to call from any thread, and from a
+	// signal handler.
+	void stop();
+
+private:
+	struct Connection
+	{
+		int socket;
+		string in;
+		string out;
+		// Requests sent to the solver and not answered yet.
+		size_t unanswered;
+		// Set once the client has shut down its side; the connection is
+		// closed when every answer is sent.
+		bool closing;
+	};
+
+	struct Job
+	{
+		uint64_t connection;
+		uint32_t id;
+		Op op;
+		string floor;
+		chrono::steady_clock::time_point received;
+	};
+
+	struct Reply
+	{
+		uint64_t connection;
+		uint32_t id;
+		Status status;
+		string payload;
+	};
+
+	ServerOptions options;
+	unique_ptr<ThreadPool> ownPool;
+	ThreadPool *pool;
+	int listener;
+	// Written to wake the I/O thread out of poll().
+	int wakeRead;
+	int wakeWrite;
+	atomic<bool> stopping;
+
+	mutex lock;
+	condition_variable work;
+	vector<Job> inbox;
+	vector<Reply> outbox;
+	bool solverStopping;
+	// Jobs submitted to the pool and not yet answered.
+	TaskGroup inFlight;
+
+	// Latencies of the most recent requests, in microseconds.
+	vector<uint32_t> latencies;
+	size_t latencyCount;
+	atomic<uint64_t> received;
+	atomic<uint64_t> answered;
+
+	void dispatch_jobs();
+	void solve_job(const Job &job);
+	void reply(const Job &job, Status status, string payload = string());
+	void read_requests(uint64_t serial, Connection &connection, vector<Job> &jobs, bool &broken);
+	string stats_text();
+};
+
+// Blocking client of a TilingServer.
+class TilingClient
+{
+public:
+	// Connects to the server at socketPath. Aborts if that fails.
+	explicit TilingClient(const string &socketPath);
+	~TilingClient();
+
+	TilingClient(const TilingClient&) = delete;
+	TilingClient& operator=(const TilingClient&) = delete;
+
+	// Sends a request without waiting for its response. Returns its id.
+	uint32_t send(Op op, string_view payload = string_view());
+
+	// Waits for the next response. Returns false if the server is gone.
+	bool receive(uint32_t &id, Status &status, string &payload);
+
+	// Tells the server no more requests are coming. The responses to
+	// those already sent still arrive, and receive() then returns false.
+	void finish_sending();
+
+	// Each sends one request and waits for its response, so no other
+	// request may be outstanding.
+	bool has_tiling(string_view floor);
+	string stats();
+	// Like find_tiling() and count_tilings(), answered by the server.
+	bool tiling(string_view floor, string &tiled);
+	bool count(string_view floor, string &count);
+
+private:
+	int socket;
+	uint32_t nextId;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+#include "bits.h"
+#include "small_floor.h"
+#include "tiny_lanes.h"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+bool load_tiny_floor(string_view floor, uint64_t &tiny)
+{
+	SmallFloor small;
+	if (!load_small_floor(floor, small) || small.rows > 8 || small.width > 8)
+		return false;
+
+	// Spread the rows out to a stride of 8.
+	tiny = 0;
+	for (int r = 0; r < small.rows; ++r)
+		for (int c = 0; c < small.width; ++c)
+		{
+			int p = r * small.width + c;
+			if ((small.bits[p >> 6] >> (p & 63)) & 1)
+				tiny |= uint64_t(1) << (8 * r + c);
+		}
+	return true;
+}
+
+// Plain words, used when no vector instructions are enabled.
+struct ScalarLanes
+{
+	static const int Width = 4;
+	struct V
+	{
+		uint64_t x[Width];
+	};
+
+	static V load(const uint64_t* p)
+	{
+		V v;
+		for (int i = 0; i < Width; ++i)
+			v.x[i] = p[i];
+		return v;
+	}
+	static void store(uint64_t* p, V a)
+	{
+		for (int i = 0; i < Width; ++i)
+			p[i] = a.x[i];
+	}
+	static V set1(uint64_t k)
+	{
+		V v;
+		for (int i = 0; i < Width; ++i)
+			v.x[i] = k;
+		return v;
+	}
+	static V and_(V a, V b)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] &= b.x[i];
+		return a;
+	}
+	static V or_(V a, V b)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] |= b.x[i];
+		return a;
+	}
+	static V xor_(V a, V b)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] ^= b.x[i];
+		return a;
+	}
+	// Returns ~a & b.
+	static V andnot(V a, V b)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] = ~a.x[i] & b.x[i];
+		return a;
+	}
+	template <int N>
+	static V shl(V a)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] <<= N;
+		return a;
+	}
+	template <int N>
+	static V shr(V a)
+	{
+		for (int i = 0; i < Width; ++i)
+			a.x[i] >>= N;
+		return a;
+	}
+	static bool any(V a)
+	{
+		uint64_t all = 0;
+		for (int i = 0; i < Width; ++i)
+			all |= a.x[i];
+		return all != 0;
+	}
+};
+
+#ifdef __AVX2__
+struct Avx2Lanes
+{
+	static const int Width = 4;
+	typedef __m256i V;
+
+	static V load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(uint64_t* p, V a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+	static V set1(uint64_t k) { return _mm256_set1_epi64x(static_cast<long long>(k)); }
+	static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+	static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+	static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+	template <int N>
+	static V shl(V a) { return _mm256_slli_epi64(a, N); }
+	template <int N>
+	static V shr(V a) { return _mm256_srli_epi64(a, N); }
+	static bool any(V a) { return !_mm256_testz_si256(a, a); }
+};
+#endif
+
+#ifdef __AVX512F__
+struct Avx512Lanes
+{
+	static const int Width = 8;
+	typedef __m512i V;
+
+	static V load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+	static void store(uint64_t* p, V a) { _mm512_storeu_si512(p, a); }
+	static V set1(uint64_t k) { return _mm512_set1_epi64(static_cast<long long>(k)); }
+	static V and_(V a, V b) { return _mm512_and_si512(a, b); }
+	static V or_(V a, V b) { return _mm512_or_si512(a, b); }
+	static V xor_(V a, V b) { return _mm512_xor_si512(a, b); }
+	static V andnot(V a, V b) { return _mm512_andnot_si512(a, b); }
+	template <int N>
+	static V shl(V a) { return _mm512_slli_epi64(a, N); }
+	template <int N>
+	static V shr(V a) { return _mm512_srli_epi64(a, N); }
+	static bool any(V a) { return _mm512_test_epi64_mask(a, a) != 0; }
+};
+#endif
+
+#if defined(__AVX512F__)
+typedef Avx512Lanes Lanes;
+#elif defined(__AVX2__)
+typedef Avx2Lanes Lanes;
+#else
+typedef ScalarLanes Lanes;
+#endif
+
+// Places forced dominoes in every lane until no lane changes. Cells left
+// in cells[i] still need a search; dead[i] has a bit set where some open
+// cell of floor i lost all its neighbors.
+template <class L>
+static void propagate(uint64_t* cells, uint64_t* dead)
+{
+	typedef typename L::V V;
+	const V NotFirstColumn = L::set1(0xFEFEFEFEFEFEFEFEULL);
+	const V NotLastColumn = L::set1(0x7F7F7F7F7F7F7F7FULL);
+
+	V m = L::load(cells);
+	V stuck = L::set1(0);
+
+	while (true)
+	{
+		V before = m;
+		for (int direction = 0; direction < 4; ++direction)
+		{
+			// Open cells whose neighbor in each direction is open.
+			V right = L::and_(L::and_(m, L::template shr<1>(m)), NotLastColumn);
+			V left = L::and_(L::and_(m, L::template shl<1>(m)), NotFirstColumn);
+			V down = L::and_(m, L::template shr<8>(m));
+			V up = L::and_(m, L::template shl<8>(m));
+
+			V any = L::or_(L::or_(right, left), L::or_(down, up));
+			stuck = L::or_(stuck, L::andnot(any, m));
+
+			// Exactly one of the four, counted in two pairs.
+			V x1 = L::xor_(right, left);
+			V x2 = L::xor_(down, up);
+			V carries = L::or_(L::or_(L::and_(right, left), L::and_(down, up)), L::and_(x1, x2));
+			V one = L::andnot(carries, L::xor_(x1, x2));
+
+			// Cells forced the same way never share a partner, so one
+			// direction can be placed all at once.
+			V forced;
+			switch (direction)
+			{
+			case 0:
+				forced = L::and_(one, right);
+				forced = L::or_(forced, L::template shl<1>(forced));
+				break;
+			case 1:
+				forced = L::and_(one, left);
+				forced = L::or_(forced, L::template shr<1>(forced));
+				break;
+			case 2:
+				forced = L::and_(one, down);
+				forced = L::or_(forced, L::template shl<8>(forced));
+				break;
+			default:
+				forced = L::and_(one, up);
+				forced = L::or_(forced, L::template shr<8>(forced));
+				break;
+			}
+			m = L::andnot(forced, m);
+		}
+		if (!L::any(L::xor_(m, before)))
+			break;
+	}
+
+	L::store(cells, m);
+	L::store(dead, stuck);
+}
+
+void tiny_has_tiling(const uint64_t* floors, size_t n, bool* answers)
+{
+	const uint64_t Black = 0x55AA55AA55AA55AAULL;
+
+	for (size_t first = 0; first < n; first += Lanes::Width)
+	{
+		uint64_t cells[Lanes::Width];
+		uint64_t dead[Lanes::Width];
+		size_t count = n - first < Lanes::Width ? n - first : Lanes::Width;
+
+		// Unbalanced floors are decided before they take a lane.
+		for (size_t i = 0; i < Lanes::Width; ++i)
+		{
+			cells[i] = 0;
+			if (i >= count)
+				continue;
+			uint64_t m = floors[first + i];
+			if (popcount64(m & Black) == popcount64(m & ~Black))
+				cells[i] = m;
+			else
+				answers[first + i] = false;
+		}
+
+		propagate<Lanes>(cells, dead);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t m = floors[first + i];
+			if (popcount64(m & Black) != popcount64(m & ~Black))
+				continue;
+			if (dead[i] != 0)
+				answers[first + i] = false;
+			else if (cells[i] == 0)
+				answers[first + i] = true;
+			else
+			{
+				SmallFloor rest = { { cells[i], 0 }, 8, 8 };
+				answers[first + i] = small_has_tiling(rest);
+			}
+		}
+	}
+}
+
+int tiny_lane_count()
+{
+	return Lanes::Width;
+}
@@ -0,0 +1,31 @@
+#ifndef TINY_LANES_H
+#define TINY_LANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+// A tiny floor is one whose open cells fit in an 8x8 box. It is held in
+// one word, cell (r, c) of the box being bit 8 * r + c.
+
+// Reads the floor into tiny if it is a tiny floor. Returns false if not.
+bool load_tiny_floor(string_view floor, uint64_t &tiny);
+
+// Decides n tiny floors, writing whether floor i has a tiling to
+// answers[i].
+//
+// One floor sits in each 64-bit lane of a vector register, and forced
+// dominoes are placed in every lane at once until no lane changes. The
+// lanes follow the instruction set enabled at compile time: 8 floors per
+// step with AVX-512, 4 with AVX2, and otherwise 4 lanes of plain words.
+// Floors still undecided afterwards are finished one by one with
+// small_has_tiling.
+void tiny_has_tiling(const uint64_t* floors, size_t n, bool* answers);
+
+// Returns the number of floors tiny_has_tiling advances per step in
+// this build.
+int tiny_lane_count();
+
+#endif
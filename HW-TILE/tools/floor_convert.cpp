@@ -0,0 +1,140 @@
+// Converts floors between the text, packed binary and PBM formats.
+//
+//   floor_convert INPUT OUTPUT
+//
+// The format of each file comes from its extension: ".hwtb" for the
+// packed format of packed_floor.h, ".rle" for the run-length format of
+// rle_floor.h, ".pbm" for PBM images (several may follow each other in
+// one file), ".gz" for compressed text (read by CompressedFloorReader,
+// written as BGZF blocks; needs HW_TILE_ZLIB) and anything else for text
+// floors separated by blank lines. Every floor of INPUT is written to
+// OUTPUT.
+//
+// Built by the Makefile, as build/floor_convert; make ZLIB=1 adds
+// .gz files.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../compressed_input.h"
+#include "../floor_batch.h"
+#include "../mapped_file.h"
+#include "../packed_floor.h"
+#include "../rle_floor.h"
+
+using namespace std;
+
+static bool ends_with(const string &path, const string &suffix)
+{
+	return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Reads every floor of a file in one of the uncompressed formats.
+static bool read_file(const string &path, vector<string> &floors, size_t &bytes)
+{
+	MappedFile input;
+	if (!input.open(path))
+		return false;
+	string_view data = input.view();
+	bytes = data.size();
+
+	size_t offset = 0;
+	if (ends_with(path, ".hwtb"))
+	{
+		PackedFloor packed;
+		while (read_packed(data, offset, packed))
+		{
+			floors.emplace_back();
+			unpack_floor(packed, floors.back());
+		}
+	}
+	else if (ends_with(path, ".rle"))
+	{
+		RunFloor runs;
+		while (read_rle(data, offset, runs))
+		{
+			floors.emplace_back();
+			decode_runs(runs, floors.back());
+		}
+	}
+	else if (ends_with(path, ".pbm"))
+	{
+		string floor;
+		while (read_pbm(data, offset, floor))
+			floors.push_back(floor);
+	}
+	else
+	{
+		vector<string_view> views;
+		split_floors(data, views);
+		floors.assign(views.begin(), views.end());
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		cerr << "usage: " << argv[0] << " INPUT OUTPUT" << endl;
+		return 2;
+	}
+	string inPath = argv[1];
+	string outPath = argv[2];
+
+	vector<string> floors;
+	size_t bytesIn = 0;
+#ifdef HW_TILE_ZLIB
+	if (ends_with(inPath, ".gz"))
+	{
+		CompressedFloorReader reader(inPath);
+		string floor;
+		while (reader.next(floor))
+			floors.push_back(floor);
+		if (!reader.ok())
+			return 1;
+		bytesIn = static_cast<size_t>(ifstream(inPath, ios::binary | ios::ate).tellg());
+	}
+	else
+#endif
+	if (!read_file(inPath, floors, bytesIn))
+		return 1;
+
+#ifdef HW_TILE_ZLIB
+	if (ends_with(outPath, ".gz"))
+	{
+		vector<string_view> views(floors.begin(), floors.end());
+		if (!write_compressed(outPath, views))
+			return 1;
+		cerr << floors.size() << " floors" << endl;
+		return 0;
+	}
+#endif
+
+	string out;
+	for (size_t i = 0; i < floors.size(); ++i)
+	{
+		if (ends_with(outPath, ".hwtb"))
+			pack_floor(floors[i], out);
+		else if (ends_with(outPath, ".rle"))
+		{
+			RunFloor runs;
+			encode_runs(floors[i], runs);
+			write_rle(runs, out);
+		}
+		else if (ends_with(outPath, ".pbm"))
+			write_pbm(floors[i], out);
+		else
+			out += (i > 0 ? "\n" : "") + floors[i];
+	}
+
+	ofstream output(outPath, ios::binary);
+	if (!output.write(out.data(), out.size()))
+	{
+		cerr << "cannot write " << outPath << endl;
+		return 1;
+	}
+	cerr << floors.size() << " floors, " << bytesIn << " bytes in, " << out.size() << " bytes out" << endl;
+	return 0;
+}
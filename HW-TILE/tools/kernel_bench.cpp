@@ -0,0 +1,214 @@
+// Times the pieces of the solver one at a time, on controlled floors.
+//
+//   kernel_bench [--kernel NAME]... [--cells N]... [--walls P] [--reps N]
+//                [--flush-bytes N] [--seed N]
+//
+// The kernels are:
+//
+//   color      color_floor, the coloring pass every solve starts with
+//   vertices   BiPartGraph::addVertices, a vertex per open cell
+//   neighbors  BiPartGraph::addNeighbors, the edges between them
+//   build      BiPartGraph::constructGraph, all of the above plus the
+//              source and sink
+//   bfs        one augmenting_path search from source to sink
+//   flow       max_flow over the whole graph
+//
+// --kernel picks the kernels to run, all of them by default. Each runs
+// on floors of about N cells for every --cells given (100 and 1000 by
+// default), rows times columns, walls included: random_maze rooms, each
+// cell a wall with probability --walls (default 0), drawn from --seed.
+// Sizes are kept small by default as the graph kernels grow faster than
+// linearly.
+//
+// Everything a kernel needs is made before its clock starts: the floor
+// colored, and the graph built up to the kernel's step. Each kernel runs
+// --reps times (default 5) warm, its input just made or used, and as
+// many times cold, after writing --flush-bytes (default 64 MiB) of
+// unrelated memory to push its input out of the caches.
+//
+// Output is CSV on standard output, a header line and then one line per
+// kernel, size and cache state:
+//
+//   kernel,cache,cells,open_cells,reps,mean_ns,min_ns,ns_per_open_cell
+//
+// ns_per_open_cell divides the mean by the number of open cells.
+//
+// Built by the Makefile, as build/kernel_bench.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../bipart_graph.h"
+#include "../floor_gen.h"
+#include "../tiling.h"
+
+using namespace std;
+
+// The state a kernel works on, brought up to its step by prepare.
+struct KernelInput
+{
+	string floor;
+	string colored;
+	unique_ptr<BiPartGraph> graph;
+	// Kept from one run to the next so that the compiler can't drop them.
+	string scratch;
+	vector<Vertex*> path;
+	int64_t sink;
+};
+
+struct Kernel
+{
+	const char *name;
+	// Brings the input up to the kernel's step, untimed.
+	function<void(KernelInput&)> prepare;
+	// The timed part.
+	function<void(KernelInput&)> run;
+};
+
+static const Kernel kernels[] = {
+	{ "color",
+		[](KernelInput &) {},
+		[](KernelInput &in) { color_floor(in.floor, in.scratch); } },
+	{ "vertices",
+		[](KernelInput &in) { in.graph = make_unique<BiPartGraph>(); },
+		[](KernelInput &in) { in.graph->addVertices(in.colored); } },
+	{ "neighbors",
+		[](KernelInput &in)
+		{
+			in.graph = make_unique<BiPartGraph>();
+			in.graph->addVertices(in.colored);
+		},
+		[](KernelInput &in) { in.graph->addNeighbors(); } },
+	{ "build",
+		[](KernelInput &in) { in.graph = make_unique<BiPartGraph>(); },
+		[](KernelInput &in) { in.graph->constructGraph(in.colored); } },
+	{ "bfs",
+		[](KernelInput &in)
+		{
+			if (!in.graph)
+			{
+				in.graph = make_unique<BiPartGraph>();
+				in.graph->constructGraph(in.colored);
+			}
+		},
+		[](KernelInput &in)
+		{
+			in.sink += augmenting_path(in.graph->GetSource(), in.graph->GetSink(), in.graph->GetVertices(), in.path);
+		} },
+	{ "flow",
+		[](KernelInput &in)
+		{
+			if (!in.graph)
+			{
+				in.graph = make_unique<BiPartGraph>();
+				in.graph->constructGraph(in.colored);
+			}
+		},
+		[](KernelInput &in) { in.sink += in.graph->getFlow(); } },
+};
+
+// A random maze of about cells cells.
+static string make_floor(uint64_t cells, double walls, FloorRandom &random)
+{
+	size_t columns = max<size_t>(3, static_cast<size_t>(sqrt(static_cast<double>(cells))));
+	size_t rows = max<size_t>(3, static_cast<size_t>(cells / columns));
+	return random_maze(rows, columns, walls, random);
+}
+
+int main(int argc, char *argv[])
+{
+	vector<string> wanted;
+	vector<uint64_t> sizes;
+	double walls = 0;
+	int reps = 5;
+	size_t flushBytes = size_t(64) << 20;
+	unsigned seed = 2018 + 'f';
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--kernel" && i + 1 < argc)
+			wanted.push_back(argv[++i]);
+		else if (arg == "--cells" && i + 1 < argc)
+			sizes.push_back(strtoull(argv[++i], nullptr, 10));
+		else if (arg == "--walls" && i + 1 < argc)
+			walls = atof(argv[++i]);
+		else if (arg == "--reps" && i + 1 < argc)
+			reps = max(1, atoi(argv[++i]));
+		else if (arg == "--flush-bytes" && i + 1 < argc)
+			flushBytes = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+		else if (arg == "--seed" && i + 1 < argc)
+			seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+		else
+		{
+			cerr << "usage: " << argv[0] << " [--kernel NAME]... [--cells N]... [--walls P] [--reps N]"
+				<< " [--flush-bytes N] [--seed N]" << endl;
+			return 2;
+		}
+	}
+	if (sizes.empty())
+		sizes = { 100, 1000 };
+	for (const string &name : wanted)
+		if (none_of(begin(kernels), end(kernels), [&](const Kernel &k) { return name == k.name; }))
+		{
+			cerr << "unknown kernel " << name << endl;
+			return 2;
+		}
+
+	vector<unsigned char> flush(flushBytes);
+	unsigned char flushed = 0;
+	int64_t sink = 0;
+
+	cout << "kernel,cache,cells,open_cells,reps,mean_ns,min_ns,ns_per_open_cell" << endl;
+	for (const Kernel &kernel : kernels)
+	{
+		if (!wanted.empty() && find(wanted.begin(), wanted.end(), kernel.name) == wanted.end())
+			continue;
+		for (uint64_t cells : sizes)
+		{
+			FloorRandom random(seed);
+			KernelInput in;
+			in.floor = make_floor(cells, walls, random);
+			color_floor(in.floor, in.colored);
+			in.sink = 0;
+			size_t open = count(in.floor.begin(), in.floor.end(), ' ');
+			size_t area = in.floor.size() - count(in.floor.begin(), in.floor.end(), '\n');
+
+			for (bool cold : { false, true })
+			{
+				// One untimed run, so that warm runs find a used input.
+				kernel.prepare(in);
+				kernel.run(in);
+				double total = 0, best = 0;
+				for (int rep = 0; rep < reps; ++rep)
+				{
+					kernel.prepare(in);
+					if (cold)
+					{
+						for (size_t k = 0; k < flush.size(); k += 64)
+							flush[k] = ++flushed;
+					}
+					auto started = chrono::steady_clock::now();
+					kernel.run(in);
+					double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - started).count();
+					total += ns;
+					best = rep == 0 ? ns : min(best, ns);
+				}
+				double mean = total / reps;
+				cout << kernel.name << ',' << (cold ? "cold" : "warm") << ',' << area << ',' << open << ','
+					<< reps << ',' << mean << ',' << best << ',' << (open ? mean / open : 0) << endl;
+			}
+			sink += in.sink + static_cast<int64_t>(in.scratch.size());
+		}
+	}
+	// Keeps the results alive.
+	sink += flush.empty() ? 0 : flush[0];
+	if (sink == -1)
+		cerr << sink << endl;
+}
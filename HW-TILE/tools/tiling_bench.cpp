@@ -0,0 +1,452 @@
+// Times has_tiling end to end over families of generated floors.
+//
+//   tiling_bench [--family NAME]... [--min-cells N] [--max-cells N]
+//                [--min-time SECONDS] [--max-time SECONDS] [--seed N]
+//   tiling_bench --sweep [--threads N] [--min-cells N] [--max-cells N]
+//                [--min-time SECONDS] [--seed N]
+//
+// Every family is run at sizes from --min-cells (default 10) up to
+// --max-cells (default 10^7) cells, a factor of 10 apart, where the cells
+// of a floor are its rows times its columns, walls included. The families
+// are:
+//
+//   open      open rectangles inside a wall
+//   maze      the random mazes of main.cpp, walls with a domino-sized
+//             hole in every inner row, half of them widened so that no
+//             tiling exists
+//   aztec     Aztec diamonds
+//   pillars   rooms with 2 by 2 pillars standing on a grid, sized so
+//             that they have a tiling
+//   corridor  a one-cell corridor winding through the floor, of even
+//             length so that it has a tiling
+//   defect    open rectangles with two cells taken out, of the same
+//             checkerboard color in half of them
+//
+// --family picks the families to run, all of them by default. Each size
+// is given a few floors, made from --seed before timing starts, which
+// are solved over and over until --min-time seconds (default 0.2) have
+// passed, and at least once. The floors come from floor_gen.h, so a seed
+// gives the same floors on every machine.
+//
+// Output is CSV on standard output, a header line and then one line per
+// family and size:
+//
+//   family,cells,floors,solves,tiled,seconds,solves_per_second,cells_per_second,peak_bytes,status
+//
+// cells is the mean over the floors, tiled the number of floors with a
+// tiling among the first round of solves, seconds the wall time of all
+// solves and peak_bytes the peak resident size of the process so far.
+// Peaks only grow, so to see the peak of one family, run it alone.
+//
+// A size still solving after --max-time seconds (default 60) has its
+// solve cancelled, which TilingContext notices between stages and before
+// each augmenting path of its flow, and status "timeout", counting only
+// the solves that finished. Building a graph can't be cancelled, so off
+// Windows each size runs in a child process, which is killed if it is
+// still running KillGrace seconds after the cancel; its status is then
+// "killed", with solves, tiled, the rates and peak_bytes left empty.
+// After a "timeout" or "killed" the larger sizes of that family are
+// skipped. Otherwise status is "ok".
+//
+// --sweep instead measures how has_tiling_batch scales, with every
+// thread count from 1 to --threads (default: the hardware's) at sizes
+// from --min-cells (default 10^4) to --max-cells (default 10^8), a factor
+// of 10 apart. Each size is run in two modes: "many" solves mazes of
+// about 1000 cells each adding up to the size, and "huge" one maze of
+// the whole size, whose rooms has_tiling_batch solves in parallel. The
+// floors are made once per size and mode, and each thread count gets
+// its own pool, made before timing starts. Output is CSV:
+//
+//   mode,cells,floors,threads,seconds,cells_per_second,speedup,efficiency,bytes_per_cell,slower
+//
+// seconds is the mean wall time of one batch, speedup the time on one
+// thread over this time and efficiency the speedup over the threads.
+// bytes_per_cell is the peak resident size during the batch, above the
+// size before the floors were made, over the cells; on Linux the peak is
+// reset for every thread count, elsewhere it only grows. slower is 1 when
+// the batch took longer than with one thread less, which is also written
+// to standard error.
+//
+// Built by the Makefile, as build/tiling_bench.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../batch.h"
+#include "../floor_gen.h"
+#include "../thread_pool.h"
+#include "../tiling.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+// Reads a size in kB from /proc/self/status, in bytes.
+static uint64_t status_bytes(const string &field)
+{
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line))
+		if (line.compare(0, field.size(), field) == 0)
+			return strtoull(line.c_str() + field.size(), nullptr, 10) * 1024;
+	return 0;
+}
+#endif
+
+// Peak resident size of the process, in bytes.
+static uint64_t peak_bytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#elif defined(__linux__)
+	return status_bytes("VmHWM:");
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// Current resident size of the process, in bytes.
+static uint64_t resident_bytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.WorkingSetSize;
+#elif defined(__linux__)
+	return status_bytes("VmRSS:");
+#else
+	return peak_bytes();
+#endif
+}
+
+// Lowers the peak resident size to the current size, where the system
+// allows it.
+static void reset_peak()
+{
+#ifdef __linux__
+	ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+// Picks rows and columns, both at least min, whose product is close to
+// cells.
+static void shape(uint64_t cells, size_t min, size_t &rows, size_t &columns)
+{
+	columns = max(min, static_cast<size_t>(sqrt(static_cast<double>(cells))));
+	rows = max<size_t>(min, static_cast<size_t>(cells / columns));
+}
+
+static string open_family(uint64_t cells, FloorRandom &)
+{
+	size_t rows, columns;
+	shape(cells, 3, rows, columns);
+	// An even number of open columns.
+	return open_room(rows, columns - (columns - 2) % 2);
+}
+
+static string maze_family(uint64_t cells, FloorRandom &random)
+{
+	size_t rows, columns;
+	shape(cells, 4, rows, columns);
+	return domino_maze(rows, max<size_t>(columns, 5), random.below(2) == 0, random);
+}
+
+static string aztec_family(uint64_t cells, FloorRandom &)
+{
+	// A diamond of order n fills about 2n by 2n cells.
+	return aztec_diamond(max<size_t>(1, static_cast<size_t>(sqrt(static_cast<double>(cells))) / 2));
+}
+
+static string pillar_family(uint64_t cells, FloorRandom &)
+{
+	size_t rows, columns;
+	shape(cells, 4, rows, columns);
+	// An even number of open rows and columns, and no pillar cut down to
+	// a single cell in the corner, so that the room has a tiling.
+	rows -= rows % 2;
+	columns -= columns % 2;
+	if ((rows - 2) % 5 == 3 && (columns - 2) % 5 == 3)
+		columns -= 2;
+	return pillar_room(rows, columns);
+}
+
+static string corridor_family(uint64_t cells, FloorRandom &)
+{
+	size_t rows, columns;
+	shape(cells, 4, rows, columns);
+	// An even number of open columns and an odd number of rows of
+	// corridor make an even length, so that the corridor has a tiling.
+	columns -= columns % 2;
+	if ((rows - 1) / 2 % 2 == 0)
+		rows -= 2;
+	return winding_corridor(rows, columns);
+}
+
+static string defect_family(uint64_t cells, FloorRandom &random)
+{
+	size_t rows, columns;
+	shape(cells, 4, rows, columns);
+	return defect_room(rows, columns - (columns - 2) % 2, random.below(2) == 0, random);
+}
+
+struct Family
+{
+	const char *name;
+	string (*make)(uint64_t cells, FloorRandom &random);
+};
+
+static const Family families[] = {
+	{ "open", open_family },
+	{ "maze", maze_family },
+	{ "aztec", aztec_family },
+	{ "pillars", pillar_family },
+	{ "corridor", corridor_family },
+	{ "defect", defect_family },
+};
+
+// Distinct floors made per family and size.
+static const size_t Variants = 4;
+
+// Seconds a size may go on after its solve was cancelled before its
+// process is killed.
+static const double KillGrace = 5;
+
+// Solves the floors of one size until minTime has passed, or until the
+// solve is cancelled after maxTime, and writes its line. Returns whether
+// it was cancelled.
+static bool run_size(const char *family, const vector<string> &floors, double mean, double minTime, double maxTime)
+{
+	// A watchdog cancels the solve running when --max-time is up.
+	TilingContext context;
+	atomic<bool> cancel(false);
+	mutex lock;
+	condition_variable finished;
+	bool done = false;
+	auto started = chrono::steady_clock::now();
+	thread watchdog([&]
+	{
+		unique_lock<mutex> guard(lock);
+		if (!finished.wait_for(guard, chrono::duration<double>(maxTime), [&] { return done; }))
+			cancel = true;
+	});
+
+	size_t tiled = 0;
+	uint64_t solves = 0;
+	double seconds = 0;
+	do
+	{
+		for (const string &floor : floors)
+		{
+			bool answer = context.solve(floor, &cancel);
+			if (cancel)
+				break;
+			if (solves < floors.size())
+				tiled += answer;
+			solves++;
+		}
+		seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+	} while (seconds < minTime && !cancel);
+	{
+		lock_guard<mutex> guard(lock);
+		done = true;
+	}
+	finished.notify_one();
+	watchdog.join();
+
+	cout << family << ',' << static_cast<uint64_t>(mean) << ',' << floors.size() << ',' << solves
+		<< ',' << tiled << ',' << seconds << ',' << solves / seconds << ',' << solves * mean / seconds
+		<< ',' << peak_bytes() << ',' << (cancel ? "timeout" : "ok") << endl;
+	return cancel;
+}
+
+// Runs every wanted family at every size, as described at the top.
+static void run_families(const vector<string> &wanted, uint64_t minCells, uint64_t maxCells, double minTime,
+	double maxTime, unsigned seed)
+{
+	cout << "family,cells,floors,solves,tiled,seconds,solves_per_second,cells_per_second,peak_bytes,status" << endl;
+	for (const Family &family : families)
+	{
+		if (!wanted.empty() && find(wanted.begin(), wanted.end(), family.name) == wanted.end())
+			continue;
+		for (uint64_t cells = max<uint64_t>(minCells, 1); cells <= maxCells; cells *= 10)
+		{
+			FloorRandom random(seed);
+			vector<string> floors;
+			uint64_t total = 0;
+			for (size_t k = 0; k < Variants; ++k)
+			{
+				floors.push_back(family.make(cells, random));
+				total += floors.back().size() - count(floors.back().begin(), floors.back().end(), '\n');
+			}
+			double mean = static_cast<double>(total) / floors.size();
+
+#ifdef _WIN32
+			if (run_size(family.name, floors, mean, minTime, maxTime))
+				break;
+#else
+			// The child shares the floors, and reports whether it was
+			// cancelled through its exit status.
+			auto started = chrono::steady_clock::now();
+			pid_t child = fork();
+			if (child < 0)
+			{
+				cerr << "cannot start a process for " << family.name << " at " << cells << " cells" << endl;
+				return;
+			}
+			if (child == 0)
+				_exit(run_size(family.name, floors, mean, minTime, maxTime) ? 1 : 0);
+
+			int status = 0;
+			bool killed = false;
+			while (waitpid(child, &status, WNOHANG) == 0)
+			{
+				double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+				if (seconds > maxTime + KillGrace)
+				{
+					kill(child, SIGKILL);
+					waitpid(child, &status, 0);
+					killed = true;
+					cout << family.name << ',' << static_cast<uint64_t>(mean) << ',' << floors.size() << ",,," << seconds
+						<< ",,,,killed" << endl;
+					break;
+				}
+				this_thread::sleep_for(chrono::milliseconds(10));
+			}
+			if (killed || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				break;
+#endif
+		}
+	}
+}
+
+// Cells of each floor in the "many" mode of --sweep.
+static const uint64_t SweepFloorCells = 1000;
+
+// Runs the thread and size sweep, as described at the top.
+static void run_sweep(unsigned maxThreads, uint64_t minCells, uint64_t maxCells, double minTime, unsigned seed)
+{
+	cout << "mode,cells,floors,threads,seconds,cells_per_second,speedup,efficiency,bytes_per_cell,slower" << endl;
+	for (uint64_t cells = max<uint64_t>(minCells, 1); cells <= maxCells; cells *= 10)
+		for (bool huge : { false, true })
+		{
+			uint64_t before = resident_bytes();
+			FloorRandom random(seed);
+			vector<string> floors;
+			if (huge)
+				floors.push_back(maze_family(cells, random));
+			else
+				for (uint64_t made = 0; made < cells; made += SweepFloorCells)
+					floors.push_back(maze_family(SweepFloorCells, random));
+			vector<string_view> views(floors.begin(), floors.end());
+
+			vector<double> times(maxThreads + 1, 0);
+			for (unsigned threads = 1; threads <= maxThreads; ++threads)
+			{
+				ThreadPool pool(threads);
+				reset_peak();
+				unsigned runs = 0;
+				double seconds = 0;
+				auto started = chrono::steady_clock::now();
+				do
+				{
+					has_tiling_batch(views, pool);
+					runs++;
+					seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+				} while (seconds < minTime);
+				times[threads] = seconds / runs;
+				uint64_t peak = peak_bytes();
+
+				double speedup = times[1] / times[threads];
+				bool slower = threads > 1 && times[threads] > times[threads - 1];
+				const char *mode = huge ? "huge" : "many";
+				cout << mode << ',' << cells << ',' << floors.size() << ',' << threads << ',' << times[threads] << ','
+					<< cells / times[threads] << ',' << speedup << ',' << speedup / threads << ','
+					<< (peak > before ? static_cast<double>(peak - before) / cells : 0) << ',' << slower << endl;
+				if (slower)
+					cerr << mode << " at " << cells << " cells is slower on " << threads << " threads ("
+						<< times[threads] << " s) than on " << threads - 1 << " (" << times[threads - 1] << " s)" << endl;
+			}
+		}
+}
+
+int main(int argc, char *argv[])
+{
+	vector<string> wanted;
+	bool sweep = false;
+	unsigned threads = thread::hardware_concurrency();
+	uint64_t minCells = 0;
+	uint64_t maxCells = 0;
+	double minTime = 0.2;
+	double maxTime = 60;
+	unsigned seed = 2018 + 'f';
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--sweep")
+			sweep = true;
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = static_cast<unsigned>(atoi(argv[++i]));
+		else if (arg == "--family" && i + 1 < argc)
+			wanted.push_back(argv[++i]);
+		else if (arg == "--min-cells" && i + 1 < argc)
+			minCells = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--max-cells" && i + 1 < argc)
+			maxCells = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--min-time" && i + 1 < argc)
+			minTime = atof(argv[++i]);
+		else if (arg == "--max-time" && i + 1 < argc)
+			maxTime = atof(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc)
+			seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+		else
+		{
+			cerr << "usage: " << argv[0]
+				<< " [--family NAME]... [--min-cells N] [--max-cells N] [--min-time SECONDS] [--max-time SECONDS] [--seed N]"
+				<< endl;
+			cerr << "       " << argv[0]
+				<< " --sweep [--threads N] [--min-cells N] [--max-cells N] [--min-time SECONDS] [--seed N]" << endl;
+			return 2;
+		}
+	}
+	for (const string &name : wanted)
+		if (none_of(begin(families), end(families), [&](const Family &f) { return name == f.name; }))
+		{
+			cerr << "unknown family " << name << endl;
+			return 2;
+		}
+
+	if (sweep)
+		run_sweep(max(threads, 1u), minCells ? minCells : 10000, maxCells ? maxCells : 100000000, minTime, seed);
+	else
+		run_families(wanted, minCells ? minCells : 10, maxCells ? maxCells : 10000000, minTime, maxTime, seed);
+}
@@ -0,0 +1,204 @@
+// Decides many floors at once, for bulk runs.
+//
+//   tiling_cli [--threads N] [--tiling] [--count] [--binary] [FILE...]
+//
+// Floors are read from each FILE in turn, or from standard input if there
+// are none or FILE is "-". Files are mapped into memory and solved where
+// they lie, so even multi-gigabyte dumps are never copied. An input holds
+// either floors separated by blank lines, or length-prefixed floors as
+// read_sized_floors expects; one whose first byte is a digit is taken to
+// be length-prefixed.
+//
+// Text output is one line per floor, in input order:
+//
+//   <index> yes|no [<count>|-]
+//
+// the count appearing with --count, "-" for floors too wide to count.
+// With --tiling, each line of a floor that has a tiling is followed by
+// the tiling as find_tiling draws it and a blank line.
+//
+// Binary output (--binary) is, per floor, one byte holding 1 or 0; then
+// with --tiling a 32-bit length and that many bytes of tiling (length 0
+// when there is none), and with --count a 32-bit length and the count in
+// decimal (length 0 when too wide). Lengths are little-endian.
+//
+// Throughput and completion times go to standard error on exit. The
+// completion time of a floor is the time from the start of the batch
+// until its answer is known, so it includes the time the floor waited
+// for a worker, not only its own solve.
+//
+// Built by the Makefile, as build/tiling_cli.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../batch.h"
+#include "../floor_batch.h"
+#include "../mapped_file.h"
+#include "../solutions.h"
+#include "../thread_pool.h"
+
+using namespace std;
+
+static size_t read_input(istream &in, FloorBatch &batch)
+{
+	int first = in.peek();
+	if (first >= '0' && first <= '9')
+		return read_sized_floors(in, batch);
+	return read_floors(in, batch);
+}
+
+static void write_length(ostream &out, size_t length)
+{
+	uint32_t value = static_cast<uint32_t>(length);
+	unsigned char bytes[4] = { static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+		static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24) };
+	out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+int main(int argc, char *argv[])
+{
+	// Before any I/O, as it has no defined effect after.
+	ios::sync_with_stdio(false);
+
+	unsigned threads = 0;
+	bool wantTiling = false;
+	bool wantCount = false;
+	bool binary = false;
+	vector<string> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+			threads = static_cast<unsigned>(atoi(argv[++i]));
+		else if (arg == "--tiling")
+			wantTiling = true;
+		else if (arg == "--count")
+			wantCount = true;
+		else if (arg == "--binary")
+			binary = true;
+		else if (arg.size() > 1 && arg[0] == '-' && arg != "-")
+		{
+			cerr << "usage: " << argv[0] << " [--threads N] [--tiling] [--count] [--binary] [FILE...]" << endl;
+			return 2;
+		}
+		else
+			paths.push_back(arg);
+	}
+	if (paths.empty())
+		paths.push_back("-");
+
+	auto started = chrono::steady_clock::now();
+
+	// Files are mapped and solved in place; only standard input is read
+	// into a batch.
+	FloorBatch batch;
+	vector<MappedFile> files(paths.size());
+	for (size_t k = 0; k < paths.size(); ++k)
+	{
+		if (paths[k] == "-")
+			read_input(cin, batch);
+		else if (!files[k].open(paths[k]))
+			return 1;
+	}
+
+	vector<string_view> floors;
+	size_t fromInput = 0;
+	for (size_t k = 0; k < paths.size(); ++k)
+	{
+		if (paths[k] == "-")
+		{
+			for (; fromInput < batch.size(); ++fromInput)
+				floors.push_back(batch[fromInput]);
+			continue;
+		}
+		string_view text = files[k].view();
+		if (!text.empty() && text[0] >= '0' && text[0] <= '9')
+			split_sized_floors(text, floors);
+		else
+			split_floors(text, floors);
+	}
+	size_t bytes = 0;
+	for (string_view floor : floors)
+		bytes += floor.size();
+
+	unique_ptr<ThreadPool> ownPool;
+	if (threads > 0)
+		ownPool = make_unique<ThreadPool>(threads);
+	ThreadPool &pool = ownPool ? *ownPool : default_pool();
+
+	auto solving = chrono::steady_clock::now();
+	vector<double> completions(floors.size());
+	vector<bool> answers = has_tiling_batch(floors, pool, [&](size_t i, bool)
+	{
+		completions[i] = chrono::duration<double>(chrono::steady_clock::now() - solving).count();
+	});
+
+	// Tilings and counts, for whichever floors need them.
+	vector<string> tilings(wantTiling ? floors.size() : 0);
+	vector<string> counts(wantCount ? floors.size() : 0);
+	if (wantTiling || wantCount)
+	{
+		TaskGroup group;
+		group.add(floors.size());
+		for (size_t i = 0; i < floors.size(); ++i)
+			pool.submit([&, i]
+			{
+				if (wantTiling && answers[i])
+					find_tiling(floors[i], tilings[i]);
+				if (wantCount && !count_tilings(floors[i], counts[i]))
+					counts[i].clear();
+				group.done();
+			});
+		group.wait(pool);
+	}
+	auto solved = chrono::steady_clock::now();
+
+	for (size_t i = 0; i < floors.size(); ++i)
+	{
+		if (binary)
+		{
+			cout.put(answers[i] ? 1 : 0);
+			if (wantTiling)
+			{
+				write_length(cout, tilings[i].size());
+				cout << tilings[i];
+			}
+			if (wantCount)
+			{
+				write_length(cout, counts[i].size());
+				cout << counts[i];
+			}
+			continue;
+		}
+
+		cout << i << (answers[i] ? " yes" : " no");
+		if (wantCount)
+			cout << ' ' << (counts[i].empty() ? "-" : counts[i]);
+		cout << '\n';
+		if (wantTiling && answers[i])
+			cout << tilings[i] << '\n';
+	}
+	cout.flush();
+
+	double total = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+	double solveTime = chrono::duration<double>(solved - solving).count();
+	sort(completions.begin(), completions.end());
+	auto percentile = [&completions](double p)
+	{
+		return completions.empty() ? 0.0 : completions[static_cast<size_t>(p * (completions.size() - 1))] * 1000;
+	};
+	size_t tiled = count(answers.begin(), answers.end(), true);
+	cerr << floors.size() << " floors, " << tiled << " with a tiling, " << bytes << " bytes" << endl;
+	cerr << "solved in " << solveTime << " s, " << total << " s in all" << endl;
+	if (solveTime > 0)
+		cerr << floors.size() / solveTime << " floors/s, " << bytes / solveTime / 1e6 << " MB/s" << endl;
+	cerr << "completion ms: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+		<< ", max " << percentile(1.0) << endl;
+	return 0;
+}
@@ -0,0 +1,82 @@
+// Long-lived server answering has_tiling, tiling and count queries on a
+// Unix domain socket.
+//
+//   tiling_daemon SOCKET [--threads N] [--cache] [--table FILE]
+//
+// --cache answers through an in-memory ResultCache, and --table also
+// keeps its answers in a PersistentCache file shared with other
+// processes. Stops cleanly on SIGINT or SIGTERM.
+//
+// Built by the Makefile, as build/tiling_daemon.
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "../persistent_cache.h"
+#include "../result_cache.h"
+#include "../tiling_server.h"
+
+using namespace std;
+
+static TilingServer *running = nullptr;
+
+static void on_signal(int)
+{
+	if (running)
+		running->stop();
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "usage: " << argv[0] << " SOCKET [--threads N] [--cache] [--table FILE]" << endl;
+		return 2;
+	}
+
+	ServerOptions options;
+	options.socketPath = argv[1];
+	bool useCache = false;
+	string tablePath;
+	for (int i = 2; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+			options.threads = static_cast<unsigned>(atoi(argv[++i]));
+		else if (arg == "--cache")
+			useCache = true;
+		else if (arg == "--table" && i + 1 < argc)
+		{
+			useCache = true;
+			tablePath = argv[++i];
+		}
+		else
+		{
+			cerr << "unknown argument " << arg << endl;
+			return 2;
+		}
+	}
+
+	ResultCache cache;
+	unique_ptr<PersistentCache> table;
+	if (!tablePath.empty())
+	{
+		table = make_unique<PersistentCache>(tablePath);
+		if (table->is_open())
+			cache.persist_to(table.get());
+		else
+			cerr << "answering without a table file" << endl;
+	}
+	if (useCache)
+		options.cache = &cache;
+
+	TilingServer server(options);
+	running = &server;
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	server.run();
+	running = nullptr;
+	return 0;
+}